@@ -0,0 +1,275 @@
+/*
+ * bit_vector_cl.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RING_BIT_VECTOR_CL_HPP
+#define RING_BIT_VECTOR_CL_HPP
+
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "configuration.hpp"
+#include "cpu_kernels.hpp"
+
+namespace ring {
+
+    template<uint8_t t_b = 1> class rank_support_cl;
+    template<uint8_t t_b = 1> class select_support_cl;
+
+    /*
+     * Bitvector whose rank directory is interleaved with the bits. Each block of 64 bytes, one cache line,
+     * holds the number of ones before the block followed by 448 bits, so a rank reads a single line.
+     * The blocks are aligned to 64 bytes in memory; in a file they start 64 bytes after the beginning of
+     * the serialized bitvector.
+     */
+    class bit_vector_cl {
+
+    public:
+        typedef uint64_t size_type;
+        typedef uint64_t value_type;
+        typedef rank_support_cl<1> rank_1_type;
+        typedef select_support_cl<1> select_1_type;
+        typedef select_support_cl<0> select_0_type;
+
+        static const uint64_t block_words = 8;
+        static_assert(block_words - 1 <= kernels::max_select_words, "the select kernels read at most 8 words");
+        static const uint64_t block_bits = 448;     //bits of data in a block
+        static const uint64_t header_bytes = 64;    //size and padding before the blocks when serialized
+
+    private:
+        size_type m_size = 0;
+        size_type m_n_blocks = 0;
+        std::vector<uint64_t> m_data;               //blocks, from the first multiple of 64 bytes
+        const uint64_t *m_blocks = nullptr;
+
+        //Allocates zeroed blocks aligned to 64 bytes
+        uint64_t *allocate(const size_type n_blocks) {
+            m_n_blocks = n_blocks;
+            m_data.assign(n_blocks * block_words + block_words - 1, 0);
+            uintptr_t p = (uintptr_t) m_data.data();
+            uint64_t *blocks = (uint64_t *) ((p + 63) & ~((uintptr_t) 63));
+            m_blocks = blocks;
+            return blocks;
+        }
+
+        void copy(const bit_vector_cl &o) {
+            m_size = o.m_size;
+            uint64_t *blocks = allocate(o.m_n_blocks);
+            if (m_n_blocks > 0) std::memcpy(blocks, o.m_blocks, m_n_blocks * block_words * sizeof(uint64_t));
+        }
+
+    public:
+        //Blocks needed for a bitvector of size bits; the last block always holds the total number of ones
+        static inline size_type n_blocks(const size_type size) {
+            return size / block_bits + 1;
+        }
+
+        bit_vector_cl() = default;
+
+        bit_vector_cl(const sdsl::bit_vector &bv) {
+            m_size = bv.size();
+            uint64_t *blocks = allocate(n_blocks(m_size));
+            uint64_t ones = 0;
+            for (size_type k = 0; k < m_n_blocks; ++k) {
+                uint64_t *b = blocks + k * block_words;
+                b[0] = ones;
+                size_type begin = k * block_bits;
+                size_type end = std::min<size_type>(begin + block_bits, m_size);
+                for (size_type i = begin; i < end; i += 64) {
+                    uint64_t len = std::min<size_type>(64, end - i);
+                    uint64_t w = bv.get_int(i, len);
+                    b[1 + (i - begin) / 64] = w;
+                    ones += __builtin_popcountll(w);
+                }
+            }
+        }
+
+        //! Copy constructor
+        bit_vector_cl(const bit_vector_cl &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        bit_vector_cl(bit_vector_cl &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        bit_vector_cl &operator=(const bit_vector_cl &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        bit_vector_cl &operator=(bit_vector_cl &&o) {
+            if (this != &o) {
+                m_size = o.m_size;
+                m_n_blocks = o.m_n_blocks;
+                m_data = std::move(o.m_data);
+                m_blocks = o.m_blocks;
+                o.m_size = 0;
+                o.m_n_blocks = 0;
+                o.m_data.clear();
+                o.m_blocks = nullptr;
+            }
+            return *this;
+        }
+
+        void swap(bit_vector_cl &o) {
+            std::swap(m_size, o.m_size);
+            std::swap(m_n_blocks, o.m_n_blocks);
+            m_data.swap(o.m_data);
+            std::swap(m_blocks, o.m_blocks);
+        }
+
+        inline size_type size() const {
+            return m_size;
+        }
+
+        inline value_type operator[](const size_type i) const {
+            const uint64_t *b = m_blocks + (i / block_bits) * block_words;
+            uint64_t off = i % block_bits;
+            return (b[1 + off / 64] >> (off % 64)) & 1ULL;
+        }
+
+        //Number of ones in [0, i)
+        inline size_type rank1(const size_type i) const {
+            const uint64_t *b = m_blocks + (i / block_bits) * block_words;
+            return b[0] + kernels::generic::rank(b + 1, i % block_bits);
+        }
+
+        //Position of the i-th one (t_b = 1) or zero (t_b = 0), i >= 1, with the kernel word_select of the same bit
+        template<uint8_t t_b>
+        size_type select(size_type i, const kernels::select_type word_select) const {
+            //Last block with less than i bits t_b before it
+            size_type lo = 0, hi = m_n_blocks;
+            while (hi - lo > 1) {
+                size_type mid = (lo + hi) / 2;
+                size_type before = t_b ? m_blocks[mid * block_words] : mid * block_bits - m_blocks[mid * block_words];
+                if (before < i) lo = mid; else hi = mid;
+            }
+            const uint64_t *b = m_blocks + lo * block_words;
+            i -= t_b ? b[0] : lo * block_bits - b[0];
+            uint64_t pos = word_select(b + 1, block_words - 1, i);
+            return pos < block_bits ? lo * block_bits + pos : m_size;
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+            size_type written_bytes = sdsl::write_member(m_size, out, child, "size");
+            const char zeros[header_bytes] = {0};
+            out.write(zeros, header_bytes - written_bytes);
+            out.write((const char *) m_blocks, m_n_blocks * block_words * sizeof(uint64_t));
+            written_bytes = header_bytes + m_n_blocks * block_words * sizeof(uint64_t);
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream &in) {
+            sdsl::read_member(m_size, in);
+            in.ignore(header_bytes - sizeof(m_size));
+            uint64_t *blocks = allocate(n_blocks(m_size));
+            in.read((char *) blocks, m_n_blocks * block_words * sizeof(uint64_t));
+        }
+    };
+
+    //Rank of ones (t_b = 1) or zeros (t_b = 0) of a bit_vector_cl. It stores nothing: the counters are in the blocks
+    template<uint8_t t_b>
+    class rank_support_cl {
+
+    public:
+        typedef uint64_t size_type;
+        typedef bit_vector_cl bit_vector_type;
+
+    private:
+        const bit_vector_cl *m_v;
+
+    public:
+        rank_support_cl(const bit_vector_cl *v = nullptr) : m_v(v) {}
+
+        inline size_type rank(const size_type i) const {
+            return t_b ? m_v->rank1(i) : i - m_v->rank1(i);
+        }
+
+        inline size_type operator()(const size_type i) const {
+            return rank(i);
+        }
+
+        void set_vector(const bit_vector_cl *v = nullptr) {
+            m_v = v;
+        }
+
+        void swap(rank_support_cl &) {}
+
+        size_type serialize(std::ostream &, sdsl::structure_tree_node * = nullptr, std::string = "") const {
+            return 0;
+        }
+
+        void load(std::istream &, const bit_vector_cl *v = nullptr) {
+            set_vector(v);
+        }
+    };
+
+    //Select of a bit_vector_cl by binary search on the counters of the blocks. It keeps the kernel of active()
+    //instead of asking for it on every select
+    template<uint8_t t_b>
+    class select_support_cl {
+
+    public:
+        typedef uint64_t size_type;
+        typedef bit_vector_cl bit_vector_type;
+
+    private:
+        const bit_vector_cl *m_v;
+        kernels::select_type m_select;
+
+    public:
+        select_support_cl(const bit_vector_cl *v = nullptr)
+                : m_v(v), m_select(t_b ? kernels::active().select1 : kernels::active().select0) {}
+
+        inline size_type select(const size_type i) const {
+            return m_v->template select<t_b>(i, m_select);
+        }
+
+        inline size_type operator()(const size_type i) const {
+            return select(i);
+        }
+
+        void set_vector(const bit_vector_cl *v = nullptr) {
+            m_v = v;
+        }
+
+        void swap(select_support_cl &) {}
+
+        size_type serialize(std::ostream &, sdsl::structure_tree_node * = nullptr, std::string = "") const {
+            return 0;
+        }
+
+        void load(std::istream &, const bit_vector_cl *v = nullptr) {
+            set_vector(v);
+        }
+    };
+}
+
+#endif //RING_BIT_VECTOR_CL_HPP
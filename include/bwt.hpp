@@ -21,17 +21,34 @@
 #ifndef BWT_T
 #define BWT_T
 
+#include "bit_vector_cl.hpp"
 #include "configuration.hpp"
+#include "index_format.hpp"
+#include "select_support_sampled.hpp"
+#include "wm_cursor.hpp"
+#include "wm_adaptive.hpp"
+#include "wm_rank.hpp"
+#include "wm_rle.hpp"
+#include "wt_alphabetic.hpp"
+#include <atomic>
+#include <type_traits>
 
 using namespace std;
 
 
 namespace ring {
 
+    //Identifier for temporary files. Unlike sdsl::util::id() it can be used by several threads
+    inline uint64_t next_tmp_id() {
+        static std::atomic<uint64_t> id(0);
+        return id++;
+    }
+
     template <class bwt_bit_vector_t = bit_vector,
             class bwt_rank_1_t = typename bit_vector::rank_1_type,
             class bwt_select_1_t = select_support_scan<1>,
-            class bwt_select_0_t = select_support_scan<0>>
+            class bwt_select_0_t = select_support_scan<0>,
+            class bwt_wm_t = sdsl::wm_int<bwt_bit_vector_t, bwt_rank_1_t, bwt_select_1_t, bwt_select_0_t>>
     class bwt {
 
     public:
@@ -41,7 +58,8 @@ namespace ring {
         typedef sdsl::rank_support_v<> c_rank_type;
         typedef sdsl::select_support_mcl<1> c_select_1_type;
         typedef sdsl::select_support_mcl<0> c_select_0_type;
-        typedef sdsl::wm_int<bwt_bit_vector_t, bwt_rank_1_t, bwt_select_1_t, bwt_select_0_t> bwt_type;
+        typedef sdsl::int_vector<> c_dense_type;
+        typedef bwt_wm_t bwt_type;
 
     private:
         bwt_type m_L;
@@ -49,6 +67,26 @@ namespace ring {
         c_rank_type m_C_rank;
         c_select_1_type m_C_select1;
         c_select_0_type m_C_select0;
+        c_dense_type m_C_dense; //C values, empty unless the alphabet is small (see use_dense_C)
+        bool m_concurrent_select = false; //see set_concurrent_select
+
+        void build(int_vector_buffer<> &L, const vector<uint64_t> &C) {
+            //Building the wavelet matrix
+            {
+                bwt_type tmp(L, L.size());
+                m_L.swap(tmp);
+            }
+            //Building C and its rank and select structures
+            m_C = c_type(C[C.size() - 1] + 1 + C.size(), 0);
+            for (uint64_t i = 0; i < C.size(); i++) {
+                m_C[C[i] + i] = 1;
+            }
+            util::init_support(m_C_rank, &m_C);
+            util::init_support(m_C_select1, &m_C);
+            util::init_support(m_C_select0, &m_C);
+            m_C_dense = c_dense_type();
+            init_C_dense();
+        }
 
         void copy(const bwt &o) {
             m_L = o.m_L;
@@ -59,24 +97,60 @@ namespace ring {
             m_C_select1.set_vector(&m_C);
             m_C_select0 = o.m_C_select0;
             m_C_select0.set_vector(&m_C);
+            m_C_dense = o.m_C_dense;
+            m_concurrent_select = o.m_concurrent_select;
         }
 
     public:
 
+        /**
+         * True if C is also stored as an array, so get_C is a load instead of a select. The array takes
+         * n_values * log(max_value) bits, and it is used when that is at most 1/4 of the bitvector of C,
+         * which has max_value + n_values bits: with the alphabet of predicates, but not with the one of
+         * subjects and objects.
+         *
+         * @param n_values      Number of values of C (size of the alphabet plus one)
+         * @param max_value     Last value of C (length of the BWT)
+         */
+        static inline bool use_dense_C(const uint64_t n_values, const uint64_t max_value) {
+            uint64_t width = bits::hi(std::max<uint64_t>(max_value, 1)) + 1;
+            return n_values * width * 4 <= max_value + n_values;
+        }
+
+
+        //Builds the array of C from its bitvector when use_dense_C holds and the array is not there yet,
+        //as after loading a file without header or a file written before the array was added
+        void init_C_dense() {
+            if (!m_C_dense.empty() || m_C.empty()) return;
+            uint64_t n_values = m_C_rank(m_C.size());
+            if (n_values == 0) return;
+            uint64_t max_value = m_C_select1(n_values) - (n_values - 1);
+            if (!use_dense_C(n_values, max_value)) return;
+            m_C_dense = c_dense_type(n_values, 0, bits::hi(std::max<uint64_t>(max_value, 1)) + 1);
+            for (uint64_t i = 0; i < n_values; i++) {
+                m_C_dense[i] = m_C_select1(i + 1) - i;
+            }
+        }
+
 
         bwt() = default;
 
         bwt(const int_vector<> &L, const vector<uint64_t> &C) {
-            //Building the wavelet matrix
-            construct_im(m_L, L);
-            //Building C and its rank and select structures
-            m_C = c_type(C[C.size() - 1] + 1 + C.size(), 0);
-            for (uint64_t i = 0; i < C.size(); i++) {
-                m_C[C[i] + i] = 1;
+            //The wavelet matrix is built through an in-memory file with a unique name,
+            //so several BWTs can be built at the same time
+            std::string tmp_file = ram_file_name("bwt_" + util::to_string(util::pid())
+                                                 + "_" + util::to_string(next_tmp_id()));
+            store_to_file(L, tmp_file);
+            {
+                int_vector_buffer<> buf(tmp_file);
+                build(buf, C);
             }
-            util::init_support(m_C_rank, &m_C);
-            util::init_support(m_C_select1, &m_C);
-            util::init_support(m_C_select0, &m_C);
+            ram_fs::remove(tmp_file);
+        }
+
+        //L is read from disk
+        bwt(int_vector_buffer<> &L, const vector<uint64_t> &C) {
+            build(L, C);
         }
 
 
@@ -109,6 +183,8 @@ namespace ring {
                 m_C_select1.set_vector(&m_C);
                 m_C_select0 = std::move(o.m_C_select0);
                 m_C_select0.set_vector(&m_C);
+                m_C_dense = std::move(o.m_C_dense);
+                m_concurrent_select = o.m_concurrent_select;
             }
             return *this;
         }
@@ -120,10 +196,13 @@ namespace ring {
             sdsl::util::swap_support(m_C_rank, o.m_C_rank, &m_C, &o.m_C);
             sdsl::util::swap_support(m_C_select1, o.m_C_select1, &m_C, &o.m_C);
             sdsl::util::swap_support(m_C_select0, o.m_C_select0, &m_C, &o.m_C);
+            m_C_dense.swap(o.m_C_dense);
+            std::swap(m_concurrent_select, o.m_concurrent_select);
         }
 
 
-        //! Serializes the data structure into the given ostream
+        //! Serializes the data structure into the given ostream, with the layout of the files without header.
+        //! The dense C is not part of it, so load builds it again from C
         size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
             sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
             size_type written_bytes = 0;
@@ -139,62 +218,111 @@ namespace ring {
         void load(std::istream &in) {
             m_L.load(in);
             m_C.load(in);
+            m_C_dense = c_dense_type();
             m_C_rank.load(in, &m_C);
             m_C_select1.load(in, &m_C);
             m_C_select0.load(in, &m_C);
+            init_C_dense();
+        }
+
+        //Calls f(name, component) for each component, and f(name, support, bitvector) for the rank and
+        //select structures (see index_format)
+        template<class t_bwt, class t_f>
+        static void sections(t_bwt &b, const std::string &prefix, t_f &f) {
+            index_format::wm_sections(b.m_L, prefix + "L.", f);
+            f(prefix + "C", b.m_C);
+            f(prefix + "C_rank", b.m_C_rank, &b.m_C);
+            f(prefix + "C_select1", b.m_C_select1, &b.m_C);
+            f(prefix + "C_select0", b.m_C_select0, &b.m_C);
+            f.optional(prefix + "C_dense", b.m_C_dense);
+        }
+
+        //Writes the size of L and C, and the details of the wavelet matrix of L (see wm_print_stats)
+        void print_stats(std::ostream &out, const std::string &prefix) const {
+            out << prefix << "L: " << sdsl::size_in_bytes(m_L) << " bytes" << std::endl;
+            wm_print_stats(m_L, out, prefix + "  ");
+            out << prefix << "C: " << sdsl::size_in_bytes(m_C) + sdsl::size_in_bytes(m_C_rank)
+                                      + sdsl::size_in_bytes(m_C_select1) + sdsl::size_in_bytes(m_C_select0)
+                                      + sdsl::size_in_bytes(m_C_dense) << " bytes" << std::endl;
         }
 
         //Operations
         inline size_type get_C(const uint64_t v) const {
+            if (!m_C_dense.empty()) return m_C_dense[v];
             return m_C_select1(v + 1) - v;
         }
 
-        inline uint64_t LF(uint64_t i) {
+        inline uint64_t LF(uint64_t i) const {
             uint64_t s = m_L[i];
             return get_C(s) + m_L.rank(i, s) - 1;
         }
 
-        uint64_t nElems(uint64_t val) {
+        uint64_t nElems(uint64_t val) const {
             return get_C(val + 1) - get_C(val);
         }
 
         pair<uint64_t, uint64_t>
-        backward_step(uint64_t left_end, uint64_t right_end, uint64_t value) {
-            return {m_L.rank(left_end, value), m_L.rank(right_end + 1, value) - 1};
+        backward_step(uint64_t left_end, uint64_t right_end, uint64_t value) const {
+            auto R = rank_pair(left_end, right_end + 1, value);
+            return {R.first, R.second - 1};
         }
 
-        inline uint64_t bsearch_C(uint64_t value) {
+        inline uint64_t bsearch_C(uint64_t value) const {
             return m_C_rank(m_C_select0(value + 1));
         }
 
 
-        inline uint64_t ranky(uint64_t pos, uint64_t val) {
+        inline uint64_t ranky(uint64_t pos, uint64_t val) const {
             return m_L.rank(pos, val);
         }
 
-        inline uint64_t rank(uint64_t pos, uint64_t val) {
+        inline uint64_t rank(uint64_t pos, uint64_t val) const {
             return m_L.rank(get_C(pos), val);
         }
 
-        inline uint64_t select(uint64_t _rank, uint64_t val) {
-            return m_L.select(_rank, val);
+        //{ranky(i, val), ranky(j, val)} with one descent of the wavelet matrix, i <= j
+        inline std::pair<uint64_t, uint64_t> rank_pair(uint64_t i, uint64_t j, uint64_t val) const {
+            return wm_rank_pair(m_L, i, j, val);
+        }
+
+        /**
+         * With concurrent, select and select_next keep the path of the wavelet matrix on the stack, so several
+         * threads can select at the same time (see wm_select). It is not part of the index.
+         *
+         * @param concurrent    True if several threads query the BWT at the same time
+         */
+        void set_concurrent_select(const bool concurrent) {
+            m_concurrent_select = concurrent;
+        }
+
+        inline bool concurrent_select() const {
+            return m_concurrent_select;
         }
 
-        inline std::pair<uint64_t, uint64_t> select_next(uint64_t pos, uint64_t val, uint64_t n_elems) {
-            return m_L.select_next(get_C(pos), val, n_elems);
+        inline uint64_t select(uint64_t _rank, uint64_t val) const {
+            return wm_select(m_L, _rank, val, m_concurrent_select);
         }
 
-        inline uint64_t min_in_range(uint64_t l, uint64_t r) {
+        inline std::pair<uint64_t, uint64_t> select_next(uint64_t pos, uint64_t val, uint64_t n_elems) const {
+            return wm_select_next(m_L, get_C(pos), val, n_elems, m_concurrent_select);
+        }
+
+        inline uint64_t min_in_range(uint64_t l, uint64_t r) const {
             return m_L.range_minimum_query(l, r);
         }
 
-        inline uint64_t range_next_value(uint64_t x, uint64_t l, uint64_t r) {
+        inline uint64_t range_next_value(uint64_t x, uint64_t l, uint64_t r) const {
             return m_L.range_next_value(x, l, r);
         }
 
+        //Same as range_next_value, resuming from the nodes kept by the cursor
+        inline uint64_t range_next_value(uint64_t x, uint64_t l, uint64_t r, wm_cursor &cursor) const {
+            return cursor.next_value(m_L, x, l, r);
+        }
+
         std::vector<uint64_t>
         //inline void
-        values_in_range(uint64_t pos_min, uint64_t pos_max) {
+        values_in_range(uint64_t pos_min, uint64_t pos_max) const {
             //interval_symbols(L, pos_min, pos_max+1, k, values, r_i, r_j);
             return m_L.all_values_in_range(pos_min, pos_max);
         }
@@ -206,7 +334,7 @@ namespace ring {
 
         // backward search for pattern of length 1
         pair<uint64_t, uint64_t> backward_search_1_rank(uint64_t P, uint64_t S) const {
-            return {m_L.rank(get_C(P), S), m_L.rank(get_C(P + 1), S)};
+            return rank_pair(get_C(P), get_C(P + 1), S);
         }
 
         // backward search for pattern PQ of length 2
@@ -219,15 +347,15 @@ namespace ring {
         pair<uint64_t, uint64_t>
         backward_search_2_rank(uint64_t P, uint64_t S, pair<uint64_t, uint64_t> &I) const {
             uint64_t c = get_C(P);
-            return {m_L.rank(c + I.first, S), m_L.rank(c + I.second, S)};
+            return rank_pair(c + I.first, c + I.second, S);
         }
 
-        inline std::pair<uint64_t, uint64_t> inverse_select(uint64_t pos)
+        inline std::pair<uint64_t, uint64_t> inverse_select(uint64_t pos) const
         {
             return m_L.inverse_select(pos);
         }
 
-        inline uint64_t operator[](uint64_t i)
+        inline uint64_t operator[](uint64_t i) const
         {
             return m_L[i];
         }
@@ -235,15 +363,59 @@ namespace ring {
     };
 
     typedef bwt<> bwt_no_select;
+
+    //True when select_next of the BWT is fast enough for the ring to step through the values of an interval.
+    //The bitvectors of bwt<> only have select_support_scan, so with it the ring uses inverse_select on the next
+    //BWT instead
+    template <class t_bwt>
+    struct has_select_next : std::true_type {};
+
+    template <>
+    struct has_select_next<bwt_no_select> : std::false_type {};
+
     typedef bwt<bit_vector,
                 typename bit_vector::rank_1_type,
                 typename bit_vector::select_1_type,
                 typename bit_vector::select_0_type> bwt_plain;
 
+    //Select with a sample every select_support_sampled<>::default_sample_rate() ones or zeros
+    typedef bwt<bit_vector,
+                typename bit_vector::rank_1_type,
+                select_support_sampled<1>,
+                select_support_sampled<0>> bwt_sampled;
+
     typedef bwt<rrr_vector<15>,
             typename rrr_vector<15>::rank_1_type,
             typename rrr_vector<15>::select_1_type,
             typename rrr_vector<15>::select_0_type> bwt_rrr;
+
+    //Rank counters interleaved with the bits (see bit_vector_cl)
+    typedef bwt<bit_vector_cl,
+            typename bit_vector_cl::rank_1_type,
+            typename bit_vector_cl::select_1_type,
+            typename bit_vector_cl::select_0_type> bwt_cl;
+
+    //Wavelet tree shaped by the frequencies of the symbols (see wt_alphabetic)
+    typedef bwt<bit_vector,
+                typename bit_vector::rank_1_type,
+                typename bit_vector::select_1_type,
+                typename bit_vector::select_0_type,
+                wt_alphabetic<>> bwt_alphabetic;
+
+    //Run-length encoded (see wm_rle); the bitvector parameters are not used
+    typedef bwt<bit_vector,
+                typename bit_vector::rank_1_type,
+                select_support_scan<1>,
+                select_support_scan<0>,
+                wm_rle<>> bwt_rle;
+
+    //Encoding of the bitvectors chosen per level of the wavelet matrix (see wm_adaptive); the bitvector
+    //parameters are not used
+    typedef bwt<bit_vector,
+                typename bit_vector::rank_1_type,
+                select_support_scan<1>,
+                select_support_scan<0>,
+                wm_adaptive> bwt_adaptive;
 }
 
 #endif
@@ -28,6 +28,7 @@ namespace ring {
         uint64_t r;
         uint64_t cur_val;  // current value within the interval
         uint64_t cur_rank;
+        wm_cursor cursor;  // path of the last value found in the interval
 
     private:
 
@@ -36,6 +37,7 @@ namespace ring {
             r = o.r;
             cur_val = o.cur_val;
             cur_rank = o.cur_rank;
+            cursor = o.cursor;
         }
 
     public:
@@ -75,6 +77,7 @@ namespace ring {
                 r = o.r;
                 cur_val = o.cur_val;
                 cur_rank = o.cur_rank;
+                cursor = std::move(o.cursor);
             }
             return *this;
         }
@@ -84,28 +87,29 @@ namespace ring {
             std::swap(r, o.r);
             std::swap(cur_val, o.cur_val);
             std::swap(cur_rank, o.cur_rank);
+            cursor.swap(o.cursor);
         }
 
         template<class Bwt>
-        uint64_t begin(Bwt &B) {
-            return B.min_in_range(l, r);
+        uint64_t begin(const Bwt &B) {
+            return B.range_next_value(0, l, r, cursor);
         }
 
         template<class Bwt>
-        uint64_t next_value(uint64_t val, Bwt &B) {
-            return B.range_next_value(val, l, r);
+        uint64_t next_value(uint64_t val, const Bwt &B) {
+            return B.range_next_value(val, l, r, cursor);
         }
 
-        inline uint64_t end() {
+        inline uint64_t end() const {
             return 0;  // assumes 0 is not stored in the triples
         }
 
-        inline uint64_t get_cur_value() {
+        inline uint64_t get_cur_value() const {
             return cur_val;
         }
 
         inline std::pair<uint64_t, uint64_t>
-        get_stored_values() {
+        get_stored_values() const {
             return std::pair<uint64_t, uint64_t>(cur_val, cur_rank);
         }
 
@@ -116,11 +120,17 @@ namespace ring {
         }
 
 
-        inline uint64_t left() {
+        //The cursor is kept: it starts again from the root if the range is not the one of its path
+        inline void set_range(uint64_t _l, uint64_t _r) {
+            l = _l;
+            r = _r;
+        }
+
+        inline uint64_t left() const {
             return l;
         }
 
-        inline uint64_t right() {
+        inline uint64_t right() const {
             return r;
         }
 
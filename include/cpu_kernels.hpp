@@ -0,0 +1,169 @@
+/*
+ * cpu_kernels.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RING_CPU_KERNELS_HPP
+#define RING_CPU_KERNELS_HPP
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define RING_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+namespace ring {
+
+    /*
+     * Rank and select kernels over the data words of a block of bit_vector_cl, and the select in a word of
+     * select_support_sampled. The rank is inlined and uses the POPCNT of the compiler flags; the selects are
+     * compiled for several instruction sets with target attributes and the set is chosen once, with CPUID,
+     * by active(). The environment variable RING_KERNELS (generic, bmi2 or avx512) restricts it to a
+     * narrower set.
+     *
+     * Only ring-cl and ring-sampled use these kernels. The selects of ring, ring-sel and c-ring, including
+     * select_next and inverse_select, still run the structures of sdsl (select_support_mcl, rrr_vector,
+     * select_support_scan) compiled with the flags of the build, and are not dispatched.
+     */
+    namespace kernels {
+
+        //Most words given to a select_type: the data words of a block of bit_vector_cl
+        const uint64_t max_select_words = 8;
+
+        //Position of the i-th one or zero in the first n words of a block, i >= 1 and n <= max_select_words
+        typedef uint64_t (*select_type)(const uint64_t *words, uint64_t n, uint64_t i);
+
+        //Position of the i-th one in w, i >= 1
+        typedef uint64_t (*word_select_type)(uint64_t w, uint64_t i);
+
+        typedef struct {
+            const char *name;
+            select_type select1;
+            select_type select0;
+            word_select_type select_word;
+        } kernel_set;
+
+        namespace generic {
+
+            inline uint64_t select_word(uint64_t w, uint64_t i) {
+                for (; i > 1; --i) w &= w - 1;
+                return __builtin_ctzll(w);
+            }
+
+            //Ones in the first off bits of words
+            inline uint64_t rank(const uint64_t *words, uint64_t off) {
+                uint64_t res = 0;
+                uint64_t n = off / 64;
+                for (uint64_t k = 0; k < n; ++k) res += __builtin_popcountll(words[k]);
+                if (off % 64) res += __builtin_popcountll(words[n] & ((1ULL << (off % 64)) - 1));
+                return res;
+            }
+
+            template<bool t_ones>
+            uint64_t select(const uint64_t *words, uint64_t n, uint64_t i) {
+                for (uint64_t k = 0; k < n; ++k) {
+                    uint64_t w = t_ones ? words[k] : ~words[k];
+                    uint64_t c = __builtin_popcountll(w);
+                    if (c >= i) return k * 64 + select_word(w, i);
+                    i -= c;
+                }
+                return n * 64;
+            }
+        }
+
+#ifdef RING_KERNELS_X86
+
+        //POPCNT, and PDEP + TZCNT for the select in a word
+        namespace bmi2 {
+
+            __attribute__((target("bmi,bmi2")))
+            inline uint64_t select_word(uint64_t w, uint64_t i) {
+                return _tzcnt_u64(_pdep_u64(1ULL << (i - 1), w));
+            }
+
+            template<bool t_ones>
+            __attribute__((target("popcnt,bmi,bmi2")))
+            uint64_t select(const uint64_t *words, uint64_t n, uint64_t i) {
+                for (uint64_t k = 0; k < n; ++k) {
+                    uint64_t w = t_ones ? words[k] : ~words[k];
+                    uint64_t c = _mm_popcnt_u64(w);
+                    if (c >= i) return k * 64 + _tzcnt_u64(_pdep_u64(1ULL << (i - 1), w));
+                    i -= c;
+                }
+                return n * 64;
+            }
+        }
+
+        //VPOPCNTQ over the words of a block at once
+        namespace avx512 {
+
+            template<bool t_ones>
+            __attribute__((target("avx512f,avx512vpopcntdq,popcnt,bmi,bmi2")))
+            uint64_t select(const uint64_t *words, uint64_t n, uint64_t i) {
+                assert(n <= max_select_words);
+                __m512i v = _mm512_maskz_loadu_epi64((__mmask8) ((1U << n) - 1), words);
+                if (!t_ones) v = _mm512_xor_si512(v, _mm512_set1_epi64(-1));
+                uint64_t counts[8];
+                _mm512_storeu_si512(counts, _mm512_popcnt_epi64(v));
+                for (uint64_t k = 0; k < n; ++k) {
+                    if (counts[k] >= i) {
+                        uint64_t w = t_ones ? words[k] : ~words[k];
+                        return k * 64 + _tzcnt_u64(_pdep_u64(1ULL << (i - 1), w));
+                    }
+                    i -= counts[k];
+                }
+                return n * 64;
+            }
+        }
+
+#endif
+
+        inline kernel_set select_kernels() {
+            const kernel_set generic_set = {"generic", generic::select<true>, generic::select<false>,
+                                            generic::select_word};
+#ifdef RING_KERNELS_X86
+            const kernel_set bmi2_set = {"bmi2", bmi2::select<true>, bmi2::select<false>, bmi2::select_word};
+            const kernel_set avx512_set = {"avx512", avx512::select<true>, avx512::select<false>,
+                                           bmi2::select_word};
+            const char *env = std::getenv("RING_KERNELS");
+            std::string limit = env ? env : "";
+            __builtin_cpu_init();
+            bool has_bmi2 = __builtin_cpu_supports("popcnt") && __builtin_cpu_supports("bmi")
+                            && __builtin_cpu_supports("bmi2");
+            bool has_avx512 = has_bmi2 && __builtin_cpu_supports("avx512f")
+                              && __builtin_cpu_supports("avx512vpopcntdq");
+            if (limit == "generic") return generic_set;
+            if (has_avx512 && limit != "bmi2") return avx512_set;
+            if (has_bmi2) return bmi2_set;
+#endif
+            return generic_set;
+        }
+
+        //Kernels for this CPU, chosen on the first call
+        inline const kernel_set &active() {
+            static const kernel_set set = select_kernels();
+            return set;
+        }
+    }
+}
+
+#endif //RING_CPU_KERNELS_HPP
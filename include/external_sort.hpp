@@ -0,0 +1,182 @@
+/*
+ * external_sort.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_EXTERNAL_SORT_HPP
+#define RING_EXTERNAL_SORT_HPP
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <queue>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "configuration.hpp"
+#include "triple_io.hpp"
+
+namespace ring {
+
+    namespace external {
+
+        struct config {
+            uint64_t memory_budget = 1ULL << 30; //Bytes used to sort and merge the triples
+            std::string tmp_dir = ".";           //Folder of the temporary files
+        };
+
+        typedef struct {
+            std::string file;
+            uint64_t size;
+        } run_type;
+
+        //Largest resident memory of the process so far, in bytes
+        inline uint64_t peak_memory() {
+            struct rusage usage;
+            if (getrusage(RUSAGE_SELF, &usage) != 0) return 0;
+            return (uint64_t) usage.ru_maxrss * 1024;
+        }
+
+        inline std::string tmp_file_name(const config &cfg, const std::string &name) {
+            return cfg.tmp_dir + "/" + name + "_" + util::to_string(util::pid()) + ".tmp";
+        }
+
+        //Buffered reader of a sorted run
+        class run_reader {
+
+        private:
+            std::ifstream m_in;
+            std::vector<spo_triple> m_buffer;
+            uint64_t m_pos = 0;
+            uint64_t m_remaining;
+
+            void fill() {
+                uint64_t k = std::min<uint64_t>(m_buffer.capacity(), m_remaining);
+                m_buffer.resize(k);
+                m_in.read((char *) m_buffer.data(), k * sizeof(spo_triple));
+                m_remaining -= k;
+                m_pos = 0;
+            }
+
+        public:
+            run_reader(const run_type &run, const uint64_t buffer_size)
+                    : m_in(run.file, std::ios::binary), m_remaining(run.size) {
+                m_buffer.reserve(std::max<uint64_t>(buffer_size, 1));
+                fill();
+            }
+
+            inline bool empty() const {
+                return m_pos == m_buffer.size();
+            }
+
+            inline const spo_triple &front() const {
+                return m_buffer[m_pos];
+            }
+
+            inline void pop() {
+                ++m_pos;
+                if (m_pos == m_buffer.size() && m_remaining > 0) fill();
+            }
+        };
+
+        /**
+         * Sorts the triples of the dataset in runs of at most memory_budget bytes, which are stored on disk.
+         *
+         * @param dataset   Text file with the triples
+         * @param cfg       Memory budget and folder of the runs
+         * @param name      Prefix of the name of the runs
+         * @param cmp       Order of the triples
+         * @return          The runs
+         */
+        template<class t_cmp>
+        std::vector<run_type> make_runs(const std::string &dataset, const config &cfg,
+                                        const std::string &name, t_cmp cmp) {
+            std::vector<run_type> runs;
+            uint64_t run_size = std::max<uint64_t>(cfg.memory_budget / sizeof(spo_triple), 1);
+            std::vector<spo_triple> chunk;
+            chunk.reserve(run_size);
+            triple_reader reader(dataset);
+            spo_triple t;
+            bool more = true;
+            while (more) {
+                more = reader.next(t);
+                if (more) chunk.push_back(t);
+                if (chunk.size() == run_size || (!more && !chunk.empty())) {
+                    std::sort(chunk.begin(), chunk.end(), cmp);
+                    run_type run;
+                    run.file = tmp_file_name(cfg, name + "_run_" + util::to_string(runs.size()));
+                    run.size = chunk.size();
+                    std::ofstream out(run.file, std::ios::binary);
+                    out.write((const char *) chunk.data(), chunk.size() * sizeof(spo_triple));
+                    runs.push_back(run);
+                    chunk.clear();
+                }
+            }
+            return runs;
+        }
+
+        /**
+         * Merges the runs and removes them from disk. Repeated triples are given only once.
+         *
+         * @param runs      Runs sorted according to cmp, which must order the three components
+         * @param cfg       Memory budget for the buffers of the runs
+         * @param cmp       Order of the triples
+         * @param f         Function called with each distinct triple in order
+         */
+        template<class t_cmp, class t_f>
+        void merge_runs(const std::vector<run_type> &runs, const config &cfg, t_cmp cmp, t_f f) {
+            typedef std::pair<spo_triple, uint64_t> item_type;
+            auto greater_item = [&cmp](const item_type &a, const item_type &b) {
+                return cmp(b.first, a.first);
+            };
+            std::priority_queue<item_type, std::vector<item_type>, decltype(greater_item)> heap(greater_item);
+
+            uint64_t buffer_size = cfg.memory_budget / (sizeof(spo_triple) * (runs.size() + 1));
+            std::vector<run_reader> readers;
+            readers.reserve(runs.size());
+            for (uint64_t i = 0; i < runs.size(); ++i) {
+                readers.emplace_back(runs[i], buffer_size);
+                if (!readers[i].empty()) {
+                    heap.push({readers[i].front(), i});
+                    readers[i].pop();
+                }
+            }
+            bool first = true;
+            spo_triple last;
+            while (!heap.empty()) {
+                item_type item = heap.top();
+                heap.pop();
+                if (first || item.first != last) {
+                    f(item.first);
+                    last = item.first;
+                    first = false;
+                }
+                run_reader &reader = readers[item.second];
+                if (!reader.empty()) {
+                    heap.push({reader.front(), item.second});
+                    reader.pop();
+                }
+            }
+            readers.clear();
+            for (const auto &run : runs) {
+                std::remove(run.file.c_str());
+            }
+        }
+    }
+}
+
+#endif //RING_EXTERNAL_SORT_HPP
@@ -26,6 +26,8 @@
 #include <vector>
 #include <utils.hpp>
 #include <unordered_set>
+#include <limits>
+#include <algorithm>
 
 namespace ring {
 
@@ -53,7 +55,7 @@ namespace ring {
         private:
             const std::vector<triple_pattern>* m_ptr_triple_patterns;
             const std::vector<ltj_iter_type>* m_ptr_iterators;
-            ring_type* m_ptr_ring;
+            const ring_type* m_ptr_ring;
 
 
             void var_to_vector(const var_type var, const size_type size,
@@ -122,7 +124,7 @@ namespace ring {
 
             gao_size(const std::vector<triple_pattern>* triple_patterns,
                         const std::vector<ltj_iter_type>* iterators,
-                        ring_type* r,
+                        const ring_type* r,
                         std::vector<var_type> &gao){
                 m_ptr_triple_patterns = triple_patterns;
                 m_ptr_iterators = iterators;
@@ -209,6 +211,228 @@ namespace ring {
 
         };
 
+        /*
+         * GAO chosen by a cost model over the statistics of the index (see stats_catalog). For each triple
+         * pattern it estimates the distinct values of each variable, and the values of a variable once other
+         * variables of the pattern are bound. Binding a variable multiplies the number of partial results by
+         * the fewest values it can take in its triple patterns, and the leaps made at its level are those
+         * values times its number of triple patterns. For up to max_dp variables the order is chosen by a
+         * DP over the subsets of bound variables, and greedily otherwise. Both are heuristics: the DP keeps
+         * only the cheapest order into each subset, but the leaps of the next variable depend on the partial
+         * results of that order, so a costlier order with fewer partial results may have led to fewer total
+         * leaps. As in gao_size, the variables that appear in only one triple pattern are placed at the end.
+         */
+        template<class ring_t = ring<>, class var_t = uint8_t, class cons_t = uint64_t >
+        class gao_cost {
+
+        public:
+            typedef var_t var_type;
+            typedef cons_t cons_type;
+            typedef uint64_t size_type;
+            typedef ring_t ring_type;
+            typedef ltj_iterator<ring_type, var_type, cons_type> ltj_iter_type;
+
+            //Orders of more variables are chosen greedily
+            static const size_type max_dp = 16;
+
+        private:
+            typedef struct {
+                double n_triples;
+                double distinct[3];   //estimated distinct values of each term
+                size_type var[3];     //index of the variable of each term in m_vars, or none
+            } pattern_info_type;
+
+            static const size_type none = (size_type) -1;
+
+            std::vector<pattern_info_type> m_patterns;
+            std::vector<var_type> m_vars;                    //variables in several triple patterns
+            std::vector<std::vector<size_type>> m_var_patterns; //triple patterns of each one of m_vars
+
+            static double cap(const double v, const double n) {
+                return std::max(1.0, std::min(v, n));
+            }
+
+            void fill_distinct(const triple_pattern &triple, const stats_catalog &stats, pattern_info_type &info) {
+                const double n = info.n_triples;
+                bool s = triple.s_is_variable(), p = triple.p_is_variable(), o = triple.o_is_variable();
+                uint64_t n_const = !s + !p + !o;
+                if (n_const >= 2) {
+                    //Each triple has a different value of the only variable
+                    info.distinct[0] = info.distinct[1] = info.distinct[2] = n;
+                } else if (n_const == 0) {
+                    info.distinct[0] = cap(stats.n_subjects(), n);
+                    info.distinct[1] = cap(stats.n_predicates(), n);
+                    info.distinct[2] = cap(stats.n_objects(), n);
+                } else if (!p) {
+                    info.distinct[0] = cap(stats.distinct_s(triple.term_p.value), n);
+                    info.distinct[1] = 1;
+                    info.distinct[2] = cap(stats.distinct_o(triple.term_p.value), n);
+                } else {
+                    //A subject or an object: its triples rarely repeat the other term
+                    info.distinct[0] = info.distinct[2] = n;
+                    info.distinct[1] = cap(stats.n_predicates(), n);
+                }
+            }
+
+            //Values of the term t of the triple pattern when the variables in bound are bound
+            double values(const pattern_info_type &info, const uint8_t t, const uint64_t bound) const {
+                double combinations = 1;
+                bool any = false;
+                for (uint8_t u = 0; u < 3; ++u) {
+                    if (u == t || info.var[u] == none || info.var[u] == info.var[t]) continue;
+                    if (bound & (1ULL << info.var[u])) {
+                        combinations *= info.distinct[u];
+                        any = true;
+                    }
+                }
+                if (!any) return info.distinct[t];
+                return std::min(info.distinct[t], std::max(1.0, info.n_triples / std::min(combinations, info.n_triples)));
+            }
+
+            //Values of the variable x when the variables in bound are bound
+            double values(const size_type x, const uint64_t bound) const {
+                double res = std::numeric_limits<double>::max();
+                for (size_type i : m_var_patterns[x]) {
+                    const pattern_info_type &info = m_patterns[i];
+                    for (uint8_t t = 0; t < 3; ++t) {
+                        if (info.var[t] == x) {
+                            res = std::min(res, values(info, t, bound));
+                            break;
+                        }
+                    }
+                }
+                return res;
+            }
+
+            //Order of m_vars that reaches each subset of bound variables with the fewest estimated leaps,
+            //keeping the partial results of that order only
+            std::vector<size_type> dp_order() const {
+                const size_type k = m_vars.size();
+                const uint64_t full = (1ULL << k) - 1;
+                std::vector<double> cost(full + 1, std::numeric_limits<double>::max());
+                std::vector<double> results(full + 1, 0);
+                std::vector<size_type> last(full + 1, none);
+                cost[0] = 0;
+                results[0] = 1;
+                for (uint64_t bound = 0; bound < full; ++bound) {
+                    if (cost[bound] == std::numeric_limits<double>::max()) continue;
+                    for (size_type x = 0; x < k; ++x) {
+                        if (bound & (1ULL << x)) continue;
+                        double v = values(x, bound);
+                        double c = cost[bound] + results[bound] * v * m_var_patterns[x].size();
+                        uint64_t next = bound | (1ULL << x);
+                        if (c < cost[next]) {
+                            cost[next] = c;
+                            results[next] = results[bound] * v;
+                            last[next] = x;
+                        }
+                    }
+                }
+                std::vector<size_type> order(k);
+                for (uint64_t bound = full, i = k; i > 0; --i) {
+                    order[i - 1] = last[bound];
+                    bound &= ~(1ULL << last[bound]);
+                }
+                return order;
+            }
+
+            //Binds at each step the variable of least estimated leaps
+            std::vector<size_type> greedy_order() const {
+                const size_type k = m_vars.size();
+                std::vector<size_type> order;
+                std::vector<bool> chosen(k, false);
+                uint64_t bound = 0; //only the first 64 variables are tracked
+                for (size_type step = 0; step < k; ++step) {
+                    size_type best = none;
+                    double best_cost = 0;
+                    for (size_type x = 0; x < k; ++x) {
+                        if (chosen[x]) continue;
+                        double c = values(x, bound) * m_var_patterns[x].size();
+                        if (best == none || c < best_cost) {
+                            best = x;
+                            best_cost = c;
+                        }
+                    }
+                    chosen[best] = true;
+                    if (best < 64) bound |= (1ULL << best);
+                    order.push_back(best);
+                }
+                return order;
+            }
+
+        public:
+
+            gao_cost(const std::vector<triple_pattern>* triple_patterns,
+                     const std::vector<ltj_iter_type>* iterators,
+                     const ring_type* r,
+                     std::vector<var_type> &gao){
+                const stats_catalog &stats = r->stats();
+
+                //1. Variables, and the number of triple patterns of each one
+                std::unordered_map<var_type, size_type> n_patterns;
+                std::vector<var_type> all_vars;
+                auto add_var = [&](const term_pattern &term) {
+                    if (!term.is_variable) return;
+                    var_type v = (var_type) term.value;
+                    if (n_patterns.find(v) == n_patterns.end()) all_vars.push_back(v);
+                    ++n_patterns[v];
+                };
+                for (const triple_pattern &triple : *triple_patterns) {
+                    add_var(triple.term_s);
+                    add_var(triple.term_p);
+                    add_var(triple.term_o);
+                }
+                std::unordered_map<var_type, size_type> position;
+                for (var_type v : all_vars) {
+                    if (n_patterns[v] > 1) {
+                        position[v] = m_vars.size();
+                        m_vars.push_back(v);
+                    }
+                }
+                m_var_patterns.resize(m_vars.size());
+
+                //2. Estimated distinct values of the terms of each triple pattern
+                std::unordered_map<var_type, size_type> lonely_weight;
+                m_patterns.resize(triple_patterns->size());
+                for (size_type i = 0; i < triple_patterns->size(); ++i) {
+                    const triple_pattern &triple = triple_patterns->at(i);
+                    pattern_info_type &info = m_patterns[i];
+                    info.n_triples = util::get_size_interval(iterators->at(i));
+                    fill_distinct(triple, stats, info);
+                    const term_pattern *terms[3] = {&triple.term_s, &triple.term_p, &triple.term_o};
+                    for (uint8_t t = 0; t < 3; ++t) {
+                        info.var[t] = none;
+                        if (!terms[t]->is_variable) continue;
+                        var_type v = (var_type) terms[t]->value;
+                        auto it = position.find(v);
+                        if (it != position.end()) {
+                            info.var[t] = it->second;
+                            auto &patterns = m_var_patterns[it->second];
+                            if (patterns.empty() || patterns.back() != i) patterns.push_back(i);
+                        } else {
+                            lonely_weight[v] = (size_type) info.n_triples;
+                        }
+                    }
+                }
+
+                //3. Order of the variables in several triple patterns, followed by the others by their weight
+                std::vector<size_type> order = (m_vars.size() <= max_dp) ? dp_order() : greedy_order();
+                gao.clear();
+                gao.reserve(all_vars.size());
+                for (size_type x : order) gao.push_back(m_vars[x]);
+                std::vector<std::pair<size_type, var_type>> lonely;
+                for (const auto &p : lonely_weight) lonely.emplace_back(p.second, p.first);
+                std::sort(lonely.begin(), lonely.end());
+                for (const auto &p : lonely) gao.push_back(p.second);
+            }
+        };
+
+        template<class ring_t, class var_t, class cons_t>
+        const typename gao_cost<ring_t, var_t, cons_t>::size_type gao_cost<ring_t, var_t, cons_t>::max_dp;
+
+        template<class ring_t, class var_t, class cons_t>
+        const typename gao_cost<ring_t, var_t, cons_t>::size_type gao_cost<ring_t, var_t, cons_t>::none;
+
     }
 }
 
@@ -0,0 +1,410 @@
+/*
+ * index_format.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_INDEX_FORMAT_HPP
+#define RING_INDEX_FORMAT_HPP
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "configuration.hpp"
+
+namespace ring {
+
+    /*
+     * File format of the indexes:
+     *
+     *  header          magic "RINGIDX", version, name of the variant (ring, c-ring, ring-sel, ...)
+     *                  and number of sections
+     *  section table   name, offset and length of each section
+     *  sections        one serialized component each (a bitvector, a rank or select structure, a
+     *                  scalar...), starting at an offset multiple of section_alignment
+     *
+     * Loaders find the components by name, so they can map them in place or skip them. Files written
+     * before this format (the components back to back) have no header and are still loaded. Components
+     * added later are visited with optional(name, x): loaders leave them as they are when the file does
+     * not have their section.
+     */
+    namespace index_format {
+
+        const char magic[8] = {'R', 'I', 'N', 'G', 'I', 'D', 'X', '\0'};
+        const uint64_t version = 1;
+        const uint64_t section_alignment = 64;
+
+        typedef struct {
+            char magic[8];
+            uint64_t version;
+            char variant[16];
+            uint64_t n_sections;
+        } header_type;
+
+        typedef struct {
+            char name[32];
+            uint64_t offset; //from the beginning of the file
+            uint64_t length;
+        } section_type;
+
+        //Name of the variant of an index, stored in the header
+        template<class t_index>
+        struct variant {
+            static std::string name() {
+                return "";
+            }
+        };
+
+        //Protected members of wm_int, reached through a derived class. They are only read: the loaders build a
+        //wm_int with its own load method (see wavelet_matrix in section_reader)
+        template<class t_wm>
+        struct wm_members : public t_wm {
+            static auto size() -> decltype(&wm_members::m_size) { return &wm_members::m_size; }
+            static auto sigma() -> decltype(&wm_members::m_sigma) { return &wm_members::m_sigma; }
+            static auto tree() -> decltype(&wm_members::m_tree) { return &wm_members::m_tree; }
+            static auto tree_rank() -> decltype(&wm_members::m_tree_rank) { return &wm_members::m_tree_rank; }
+            static auto tree_select1() -> decltype(&wm_members::m_tree_select1) { return &wm_members::m_tree_select1; }
+            static auto tree_select0() -> decltype(&wm_members::m_tree_select0) { return &wm_members::m_tree_select0; }
+            static auto max_level() -> decltype(&wm_members::m_max_level) { return &wm_members::m_max_level; }
+            static auto zero_cnt() -> decltype(&wm_members::m_zero_cnt) { return &wm_members::m_zero_cnt; }
+            static auto rank_level() -> decltype(&wm_members::m_rank_level) { return &wm_members::m_rank_level; }
+        };
+
+        //Sections of the members of a wm_int, in the order of wm_int::serialize
+        const char *const wm_member_names[] = {"size", "sigma", "tree", "tree_rank", "tree_select1", "tree_select0",
+                                               "max_level", "zero_cnt", "rank_level"};
+
+        /**
+         * Calls f(name, component) for each member of a wavelet matrix, and f(name, support, bitvector) for
+         * its rank and select structures, in the order of wm_member_names.
+         *
+         * @param wm        Wavelet matrix (const when it is written)
+         * @param prefix    Prefix of the names of the sections
+         * @param f         Visitor
+         */
+        template<class t_wm, class t_f>
+        void wm_member_sections(t_wm &wm, const std::string &prefix, t_f &f) {
+            typedef wm_members<typename std::remove_const<t_wm>::type> members;
+            f(prefix + "size", wm.*members::size());
+            f(prefix + "sigma", wm.*members::sigma());
+            f(prefix + "tree", wm.*members::tree());
+            f(prefix + "tree_rank", wm.*members::tree_rank(), &(wm.*members::tree()));
+            f(prefix + "tree_select1", wm.*members::tree_select1(), &(wm.*members::tree()));
+            f(prefix + "tree_select0", wm.*members::tree_select0(), &(wm.*members::tree()));
+            f(prefix + "max_level", wm.*members::max_level());
+            f(prefix + "zero_cnt", wm.*members::zero_cnt());
+            f(prefix + "rank_level", wm.*members::rank_level());
+        }
+
+        /**
+         * Visits a wavelet matrix stored with one section per member. The visitor chooses how with
+         * f.wavelet_matrix(prefix, wm): the writer writes the members, and the loaders give the sections,
+         * one after the other, to wm_int::load.
+         *
+         * @param wm        Wavelet matrix (const when it is written)
+         * @param prefix    Prefix of the names of the sections
+         * @param f         Visitor
+         */
+        template<class t_wm, class t_f>
+        void wm_sections(t_wm &wm, const std::string &prefix, t_f &f) {
+            f.wavelet_matrix(prefix, wm);
+        }
+
+        inline uint64_t padding(const uint64_t offset) {
+            return (section_alignment - offset % section_alignment) % section_alignment;
+        }
+
+        //Table of sections of an index
+        class section_table {
+
+        private:
+            header_type m_header;
+            std::vector<section_type> m_sections;
+
+        public:
+            section_table() = default;
+
+            //Reads the header and the table from memory. Returns false if the data has no header
+            bool read(const char *data, const uint64_t size) {
+                if (size < sizeof(header_type)) return false;
+                std::memcpy(&m_header, data, sizeof(header_type));
+                if (std::memcmp(m_header.magic, magic, sizeof(magic)) != 0) return false;
+                if (m_header.version != version) throw std::runtime_error("Unsupported version of the index");
+                if (size < sizeof(header_type) + m_header.n_sections * sizeof(section_type)) {
+                    throw std::runtime_error("Truncated index");
+                }
+                m_sections.resize(m_header.n_sections);
+                std::memcpy(m_sections.data(), data + sizeof(header_type), m_header.n_sections * sizeof(section_type));
+                return true;
+            }
+
+            //Reads the header and the table from a stream. Returns false, and leaves the stream where it
+            //was, if the data has no header
+            bool read(std::istream &in) {
+                std::streampos start = in.tellg();
+                in.read((char *) &m_header, sizeof(header_type));
+                if (!in || std::memcmp(m_header.magic, magic, sizeof(magic)) != 0) {
+                    in.clear();
+                    in.seekg(start);
+                    return false;
+                }
+                if (m_header.version != version) throw std::runtime_error("Unsupported version of the index");
+                m_sections.resize(m_header.n_sections);
+                in.read((char *) m_sections.data(), m_header.n_sections * sizeof(section_type));
+                if (!in) throw std::runtime_error("Truncated index");
+                return true;
+            }
+
+            inline std::string variant() const {
+                return std::string(m_header.variant, strnlen(m_header.variant, sizeof(m_header.variant)));
+            }
+
+            inline const std::vector<section_type> &sections() const {
+                return m_sections;
+            }
+
+            bool contains(const std::string &name) const {
+                for (const auto &s : m_sections) {
+                    if (name == std::string(s.name, strnlen(s.name, sizeof(s.name)))) return true;
+                }
+                return false;
+            }
+
+            const section_type &find(const std::string &name) const {
+                for (const auto &s : m_sections) {
+                    if (name == std::string(s.name, strnlen(s.name, sizeof(s.name)))) return s;
+                }
+                throw std::runtime_error("Missing section " + name + " in the index");
+            }
+        };
+
+        //Name of the variant stored in an index file, or an empty string for files without header
+        inline std::string read_variant(const std::string &file) {
+            std::ifstream in(file, std::ios::binary);
+            section_table table;
+            return table.read(in) ? table.variant() : "";
+        }
+
+        //Visitor that writes the sections of an index
+        class section_writer {
+
+        private:
+            typedef std::function<uint64_t(std::ostream &, sdsl::structure_tree_node *)> write_type;
+
+            std::vector<std::string> m_names;
+            std::vector<uint64_t> m_lengths;
+            std::vector<write_type> m_writes;
+
+            template<class t_data>
+            void add(const std::string &name, const t_data &x, std::false_type) {
+                m_names.push_back(name);
+                m_lengths.push_back(sdsl::size_in_bytes(x));
+                m_writes.emplace_back([&x, name](std::ostream &out, sdsl::structure_tree_node *v) {
+                    return (uint64_t) x.serialize(out, v, name);
+                });
+            }
+
+            template<class t_data>
+            void add(const std::string &name, const t_data &x, std::true_type) {
+                m_names.push_back(name);
+                m_lengths.push_back(sizeof(t_data));
+                m_writes.emplace_back([&x, name](std::ostream &out, sdsl::structure_tree_node *v) {
+                    return (uint64_t) sdsl::write_member(x, out, v, name);
+                });
+            }
+
+        public:
+            template<class t_data>
+            void operator()(const std::string &name, const t_data &x) {
+                add(name, x, std::is_arithmetic<t_data>());
+            }
+
+            template<class t_support, class t_vector>
+            void operator()(const std::string &name, const t_support &x, const t_vector *) {
+                add(name, x, std::false_type());
+            }
+
+            template<class t_data>
+            void optional(const std::string &name, const t_data &x) {
+                (*this)(name, x);
+            }
+
+            template<class t_wm>
+            void wavelet_matrix(const std::string &prefix, const t_wm &wm) {
+                wm_member_sections(wm, prefix, *this);
+            }
+
+            /**
+             * Writes the header, the table and the sections.
+             *
+             * @param out       Output stream
+             * @param name      Name of the variant of the index
+             * @param v         Node of the structure tree
+             * @return          Bytes written
+             */
+            uint64_t write(std::ostream &out, const std::string &name, sdsl::structure_tree_node *v) {
+                header_type header;
+                std::memset(&header, 0, sizeof(header));
+                std::memcpy(header.magic, magic, sizeof(magic));
+                header.version = version;
+                std::strncpy(header.variant, name.c_str(), sizeof(header.variant) - 1);
+                header.n_sections = m_names.size();
+
+                std::vector<section_type> table(m_names.size());
+                uint64_t offset = sizeof(header_type) + table.size() * sizeof(section_type);
+                for (uint64_t i = 0; i < table.size(); ++i) {
+                    if (m_names[i].size() >= sizeof(table[i].name)) {
+                        throw std::runtime_error("Name of section too long: " + m_names[i]);
+                    }
+                    std::memset(table[i].name, 0, sizeof(table[i].name));
+                    std::memcpy(table[i].name, m_names[i].data(), m_names[i].size());
+                    offset += padding(offset);
+                    table[i].offset = offset;
+                    table[i].length = m_lengths[i];
+                    offset += m_lengths[i];
+                }
+
+                uint64_t written_bytes = 0;
+                out.write((const char *) &header, sizeof(header));
+                out.write((const char *) table.data(), table.size() * sizeof(section_type));
+                written_bytes += sizeof(header) + table.size() * sizeof(section_type);
+                const char zeros[section_alignment] = {0};
+                for (uint64_t i = 0; i < table.size(); ++i) {
+                    out.write(zeros, table[i].offset - written_bytes);
+                    written_bytes = table[i].offset;
+                    uint64_t w = m_writes[i](out, v);
+                    if (w != table[i].length) throw std::runtime_error("Unexpected size of section " + m_names[i]);
+                    written_bytes += w;
+                }
+                return written_bytes;
+            }
+        };
+
+        //Stream buffer that reads several sections of a stream one after the other, as if they were contiguous
+        class section_stream_buffer : public std::streambuf {
+
+        private:
+            std::istream &m_in;
+            std::streampos m_start;
+            std::vector<section_type> m_sections;
+            uint64_t m_next = 0;    //section being read
+            uint64_t m_offset = 0;  //bytes of the section already read
+            std::vector<char> m_buffer;
+
+        protected:
+            int_type underflow() override {
+                while (m_next < m_sections.size() && m_offset == m_sections[m_next].length) {
+                    ++m_next;
+                    m_offset = 0;
+                }
+                if (m_next == m_sections.size()) return traits_type::eof();
+                const section_type &s = m_sections[m_next];
+                uint64_t n = std::min<uint64_t>(m_buffer.size(), s.length - m_offset);
+                m_in.seekg(m_start + (std::streamoff) (s.offset + m_offset));
+                m_in.read(m_buffer.data(), n);
+                if ((uint64_t) m_in.gcount() != n) return traits_type::eof();
+                m_offset += n;
+                setg(m_buffer.data(), m_buffer.data(), m_buffer.data() + n);
+                return traits_type::to_int_type(m_buffer[0]);
+            }
+
+        public:
+            section_stream_buffer(std::istream &in, const std::streampos start,
+                                  const std::vector<section_type> &sections)
+                    : m_in(in), m_start(start), m_sections(sections), m_buffer(1 << 16) {}
+        };
+
+        //Visitor that loads the sections of an index from a stream
+        class section_reader {
+
+        private:
+            std::istream &m_in;
+            std::streampos m_start;
+            section_table m_table;
+            bool m_has_table;
+
+            void seek(const std::string &name) {
+                const section_type &s = m_table.find(name);
+                m_in.seekg(m_start + (std::streamoff) s.offset);
+            }
+
+        public:
+            section_reader(std::istream &in) : m_in(in), m_start(in.tellg()) {
+                m_has_table = m_table.read(in);
+            }
+
+            //False for files without header, which must be loaded with the old layout
+            inline bool has_table() const {
+                return m_has_table;
+            }
+
+            template<class t_data>
+            void operator()(const std::string &name, t_data &x) {
+                seek(name);
+                load(x, std::is_arithmetic<t_data>());
+            }
+
+            template<class t_support, class t_vector>
+            void operator()(const std::string &name, t_support &x, const t_vector *v) {
+                seek(name);
+                x.load(m_in, v);
+            }
+
+            template<class t_data>
+            void optional(const std::string &name, t_data &x) {
+                if (m_table.contains(name)) (*this)(name, x);
+            }
+
+            //Loads a wm_int with its load method, reading the sections of its members as one stream
+            template<class t_wm>
+            void wavelet_matrix(const std::string &prefix, t_wm &wm) {
+                std::vector<section_type> sections;
+                for (const char *name : wm_member_names) sections.push_back(m_table.find(prefix + name));
+                section_stream_buffer buf(m_in, m_start, sections);
+                std::istream in(&buf);
+                wm.load(in);
+                if (!in) throw std::runtime_error("Truncated index");
+            }
+
+            //Leaves the stream at the end of the index
+            void finish() {
+                uint64_t end = sizeof(header_type) + m_table.sections().size() * sizeof(section_type);
+                for (const auto &s : m_table.sections()) end = std::max(end, s.offset + s.length);
+                m_in.seekg(m_start + (std::streamoff) end);
+            }
+
+        private:
+            template<class t_data>
+            void load(t_data &x, std::false_type) {
+                x.load(m_in);
+            }
+
+            template<class t_data>
+            void load(t_data &x, std::true_type) {
+                sdsl::read_member(x, m_in);
+            }
+        };
+    }
+}
+
+#endif //RING_INDEX_FORMAT_HPP
@@ -23,10 +23,18 @@
 #define RING_LTJ_ALGORITHM_HPP
 
 
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
 #include <triple_pattern.hpp>
 #include <ring.hpp>
 #include <ltj_iterator.hpp>
 #include <gao.hpp>
+#include <parallel.hpp>
+#include <plan_cache.hpp>
+#include <utils.hpp>
 
 namespace ring {
 
@@ -43,14 +51,55 @@ namespace ring {
         typedef std::unordered_map<var_type, std::vector<ltj_iter_type*>> var_to_iterators_type;
         typedef std::vector<std::pair<var_type, value_type>> tuple_type;
         typedef std::chrono::high_resolution_clock::time_point time_point_type;
+        typedef plan_cache<var_type> plan_cache_type;
+        typedef typename plan_cache_type::plan_type plan_type;
+        typedef std::vector<typename ltj_iter_type::bounds_type> iterator_bounds_type;
 
     private:
+        //Iterator of a variable with its state (make_state) at the level of the variable in the GAO
+        typedef struct {
+            ltj_iter_type* iter;
+            uint8_t state;
+        } step_type;
+
+        typedef struct {
+            std::vector<step_type> steps;
+            bool lonely; //only one iterator, which is in its last level
+            iterator_bounds_type saved; //in the adaptive order, the bounds of the iterators before being bound
+        } level_type;
+
         const std::vector<triple_pattern>* m_ptr_triple_patterns;
         std::vector<var_type> m_gao; //TODO: should be a class
-        ring_type* m_ptr_ring;
+        const ring_type* m_ptr_ring;
         std::vector<ltj_iter_type> m_iterators;
         var_to_iterators_type m_var_to_iterators;
+        std::vector<level_type> m_levels; //m_levels[j] for the variable m_gao[j]
+        std::vector<uint8_t> m_const_mask; //terms of each iterator bound to a constant of its triple pattern
+        size_type m_n_adaptive = 0; //variables at the beginning of the GAO that appear in several triples
+        bool m_adaptive = false;
         bool m_is_empty = false;
+        size_type m_n_leaps = 0; //calls to leap made by seek_level
+
+        //Shared by the tasks of a parallel join
+        struct parallel_state_type {
+            parallel::work_stealing_pool pool;
+            std::function<bool(const tuple_type &)> sink;
+            std::mutex sink_mutex; //the sink is called by one thread at a time
+            size_type n_results; //guarded by sink_mutex
+            std::atomic<bool> stop;
+            std::atomic<size_type> n_leaps; //of the tasks that are copies of the algorithm
+            time_point_type start;
+            size_type limit_results;
+            size_type timeout_seconds;
+
+            parallel_state_type(const size_type n_threads) : pool(n_threads), n_results(0), stop(false), n_leaps(0) {}
+        };
+
+        //The subtrees of the first parallel_levels variables of the GAO can be moved to other threads
+        static const size_type parallel_levels = 2;
+
+        //Constant given to seek_level when the search of a variable starts
+        static const value_type unknown = (value_type) -1;
 
 
         void copy(const ltj_algorithm &o) {
@@ -59,7 +108,126 @@ namespace ring {
             m_ptr_ring = o.m_ptr_ring;
             m_iterators = o.m_iterators;
             m_var_to_iterators = o.m_var_to_iterators;
+            m_levels = o.m_levels;
+            m_const_mask = o.m_const_mask;
+            m_n_adaptive = o.m_n_adaptive;
+            m_adaptive = o.m_adaptive;
             m_is_empty = o.m_is_empty;
+            m_n_leaps = o.m_n_leaps;
+            //The pointers must refer to the copies of the iterators
+            for (auto &p : m_var_to_iterators) {
+                for (ltj_iter_type* &ptr : p.second) {
+                    ptr = m_iterators.data() + (ptr - o.m_iterators.data());
+                }
+            }
+            for (auto &level : m_levels) {
+                for (step_type &step : level.steps) {
+                    step.iter = m_iterators.data() + (step.iter - o.m_iterators.data());
+                }
+            }
+        }
+
+        //The state of each iterator at each level of the GAO is known before the search: its constants
+        //and the variables of the previous levels are bound. The transitions are chosen here once.
+        void build_levels(){
+            std::vector<uint8_t> bound(m_iterators.size());
+            for(size_type i = 0; i < m_iterators.size(); ++i){
+                bound[i] = m_iterators[i].bound_mask();
+            }
+            m_const_mask = bound;
+            m_levels.resize(m_gao.size());
+            for(size_type j = 0; j < m_gao.size(); ++j){
+                const std::vector<ltj_iter_type*>& itrs = m_var_to_iterators[m_gao[j]];
+                level_type &level = m_levels[j];
+                level.steps.clear();
+                for(ltj_iter_type* iter : itrs){
+                    size_type i = iter - m_iterators.data();
+                    uint8_t t = iter->term(m_gao[j]);
+                    level.steps.push_back({iter, ltj_iter_type::make_state(t, bound[i])});
+                }
+                level.lonely = itrs.size() == 1 && __builtin_popcount(bound[itrs[0] - m_iterators.data()]) >= 2;
+                for(ltj_iter_type* iter : itrs){
+                    bound[iter - m_iterators.data()] |= (1 << iter->term(m_gao[j]));
+                }
+            }
+            set_n_adaptive();
+        }
+
+        //The levels of a plan chosen for another query with the same shape, instead of build_levels
+        void set_levels(const plan_type &plan){
+            m_gao = plan.gao;
+            m_const_mask.resize(m_iterators.size());
+            for(size_type i = 0; i < m_iterators.size(); ++i){
+                m_const_mask[i] = m_iterators[i].bound_mask();
+            }
+            m_levels.resize(m_gao.size());
+            for(size_type j = 0; j < m_gao.size(); ++j){
+                level_type &level = m_levels[j];
+                level.steps.clear();
+                for(const auto &step : plan.steps[j]){
+                    level.steps.push_back({&m_iterators[step.pattern], step.state});
+                }
+                level.lonely = plan.lonely[j];
+            }
+            set_n_adaptive();
+        }
+
+        //The GAO ends with the variables that appear in only one triple pattern
+        void set_n_adaptive(){
+            m_n_adaptive = m_gao.size();
+            while(m_n_adaptive > 0 && m_var_to_iterators[m_gao[m_n_adaptive-1]].size() == 1){
+                --m_n_adaptive;
+            }
+        }
+
+        plan_type plan() const {
+            plan_type res;
+            res.gao = m_gao;
+            res.steps.resize(m_levels.size());
+            res.lonely.resize(m_levels.size());
+            for(size_type j = 0; j < m_levels.size(); ++j){
+                for(const step_type &step : m_levels[j].steps){
+                    res.steps[j].push_back({(size_type) (step.iter - m_iterators.data()), step.state});
+                }
+                res.lonely[j] = m_levels[j].lonely;
+            }
+            return res;
+        }
+
+        //In the adaptive order, the variables before m_n_adaptive are chosen during the search, so the steps of
+        //their levels are set by choose_var
+        inline bool is_adaptive_level(const size_type j) const {
+            return m_adaptive && j < m_n_adaptive;
+        }
+
+        //Moves to position j of the GAO the variable of positions [j, m_n_adaptive) with the smallest
+        //interval in the current state, preferring those that share a triple pattern with a bound variable.
+        //The variables after m_n_adaptive keep their order, so their transitions do not change. The steps of
+        //level j are those of the chosen variable in the current state
+        void choose_var(const size_type j){
+            size_type best = j, best_weight = UINT64_MAX;
+            bool best_related = false;
+            for(size_type k = j; k < m_n_adaptive; ++k){
+                size_type weight = UINT64_MAX;
+                bool related = false;
+                for(const ltj_iter_type* iter : m_var_to_iterators[m_gao[k]]){
+                    weight = std::min(weight, util::get_size_interval(*iter));
+                    related = related || iter->bound_mask() != m_const_mask[iter - m_iterators.data()];
+                }
+                if((related && !best_related) || (related == best_related && weight < best_weight)){
+                    best = k;
+                    best_weight = weight;
+                    best_related = related;
+                }
+            }
+            std::swap(m_gao[j], m_gao[best]);
+            const std::vector<ltj_iter_type*>& itrs = m_var_to_iterators[m_gao[j]];
+            level_type &level = m_levels[j];
+            level.steps.clear();
+            for(ltj_iter_type* iter : itrs){
+                level.steps.push_back({iter, ltj_iter_type::make_state(iter->term(m_gao[j]), iter->bound_mask())});
+            }
+            level.lonely = itrs.size() == 1 && __builtin_popcount(itrs[0]->bound_mask()) >= 2;
         }
 
 
@@ -78,7 +246,14 @@ namespace ring {
 
         ltj_algorithm() = default;
 
-        ltj_algorithm(const std::vector<triple_pattern>* triple_patterns, ring_type* ring){
+        /**
+         * @param triple_patterns   Query
+         * @param ring              Ring
+         * @param plans             Plans of the previous queries: the plan of this query is taken from it,
+         *                          or computed and added to it
+         */
+        ltj_algorithm(const std::vector<triple_pattern>* triple_patterns, const ring_type* ring,
+                      plan_cache_type* plans = nullptr){
 
             m_ptr_triple_patterns = triple_patterns;
             m_ptr_ring = ring;
@@ -106,7 +281,26 @@ namespace ring {
                 ++i;
             }
 
-            gao::gao_size<ring_type> gao_sv2(m_ptr_triple_patterns, &m_iterators, m_ptr_ring, m_gao);
+            //The GAO depends on the triples that match the constants, so they are part of the key of the plan
+            std::vector<size_type> sizes;
+            if(plans != nullptr){
+                sizes.reserve(m_iterators.size());
+                for(const ltj_iter_type &iter : m_iterators) sizes.push_back(util::get_size_interval(iter));
+                plan_type cached;
+                if(plans->find(*m_ptr_triple_patterns, sizes, cached)){
+                    set_levels(cached);
+                    return;
+                }
+            }
+
+            //Indexes built before the statistics were added keep the GAO by sizes
+            if(m_ptr_ring->stats().empty()){
+                gao::gao_size<ring_type> gao_sv2(m_ptr_triple_patterns, &m_iterators, m_ptr_ring, m_gao);
+            }else{
+                gao::gao_cost<ring_type> gao_c(m_ptr_triple_patterns, &m_iterators, m_ptr_ring, m_gao);
+            }
+            build_levels();
+            if(plans != nullptr && !m_gao.empty()) plans->insert(*m_ptr_triple_patterns, sizes, plan());
 
         }
 
@@ -136,18 +330,89 @@ namespace ring {
                 m_ptr_ring = std::move(o.m_ptr_ring);
                 m_iterators = std::move(o.m_iterators);
                 m_var_to_iterators = std::move(o.m_var_to_iterators);
+                m_levels = std::move(o.m_levels);
+                m_const_mask = std::move(o.m_const_mask);
+                m_n_adaptive = o.m_n_adaptive;
+                m_adaptive = o.m_adaptive;
                 m_is_empty = o.m_is_empty;
+                m_n_leaps = o.m_n_leaps;
             }
             return *this;
         }
 
+        //Bounds of the iterators, to restore them with rebind
+        void save_bounds(iterator_bounds_type &bounds) const {
+            bounds.resize(m_iterators.size());
+            for(size_type i = 0; i < m_iterators.size(); ++i){
+                m_iterators[i].save(bounds[i]);
+            }
+        }
+
+        /**
+         * Prepares the iterators for new values of the constants of some triple patterns, keeping the GAO
+         * and the transitions, which only depend on which terms are constants. The iterators of the changed
+         * triple patterns are built again over their constants, in place; the others are only restored to
+         * the bounds they had when they were built, without searching the ring. The algorithm must have been
+         * built with iterators that were not empty.
+         *
+         * @param changed   changed[i] if the constants of the i-th triple pattern have changed
+         * @param initial   Bounds saved with save_bounds after the algorithm was built
+         * @return          False if the join is empty
+         */
+        bool rebind(const std::vector<bool> &changed, const iterator_bounds_type &initial){
+            m_is_empty = false;
+            for(size_type i = 0; i < m_iterators.size(); ++i){
+                if(!changed[i]){
+                    m_iterators[i].restore(initial[i]);
+                    continue;
+                }
+                m_iterators[i] = ltj_iter_type(&m_ptr_triple_patterns->at(i), m_ptr_ring);
+                if(m_iterators[i].is_empty){
+                    m_is_empty = true;
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        //True if the iterator of a triple pattern is empty, so the join has no results
+        inline bool is_empty() const {
+            return m_is_empty;
+        }
+
+        //Order of the variables chosen when the query was built
+        inline const std::vector<var_type> &gao() const {
+            return m_gao;
+        }
+
+        //Calls to leap made by the joins run so far, to compare the strategies of intersection
+        inline size_type n_leaps() const {
+            return m_n_leaps;
+        }
+
+        /**
+         * Chooses the next variable at each node of the search, instead of following the GAO computed
+         * when the query is built. Among the variables that appear in several triple patterns, the search
+         * binds first the one with the smallest interval under the current bindings.
+         *
+         * @param adaptive  True for the adaptive order
+         */
+        void set_adaptive(const bool adaptive){
+            m_adaptive = adaptive;
+        }
+
         void swap(ltj_algorithm &o) {
             std::swap(m_ptr_triple_patterns, o.m_ptr_triple_patterns);
             std::swap(m_gao, o.m_gao);
             std::swap(m_ptr_ring, o.m_ptr_ring);
             std::swap(m_iterators, o.m_iterators);
             std::swap(m_var_to_iterators, o.m_var_to_iterators);
+            std::swap(m_levels, o.m_levels);
+            std::swap(m_const_mask, o.m_const_mask);
+            std::swap(m_n_adaptive, o.m_n_adaptive);
+            std::swap(m_adaptive, o.m_adaptive);
             std::swap(m_is_empty, o.m_is_empty);
+            std::swap(m_n_leaps, o.m_n_leaps);
         }
 
 
@@ -159,10 +424,118 @@ namespace ring {
         */
         void join(std::vector<tuple_type> &res,
                   const size_type limit_results = 0, const size_type timeout_seconds = 0){
-            if(m_is_empty) return;
+            join_stream([&res](const tuple_type &t){
+                res.emplace_back(t);
+                return true;
+            }, limit_results, timeout_seconds);
+        };
+
+        /**
+         * Join that reports each result to a sink as soon as it is found, without storing it. The tuple
+         * given to the sink belongs to the search and is overwritten by the next result.
+         *
+         * @param sink              Called as sink(const tuple_type &) for each result. The join stops
+         *                          when it returns false
+         * @param limit_results     Limit of results
+         * @param timeout_seconds   Timeout in seconds
+         * @return                  Number of results
+         */
+        template<class t_sink>
+        size_type join_stream(t_sink &&sink,
+                              const size_type limit_results = 0, const size_type timeout_seconds = 0){
+            if(m_is_empty) return 0;
             time_point_type start = std::chrono::high_resolution_clock::now();
             tuple_type t(m_gao.size());
-            search(0, t, res, start, limit_results, timeout_seconds);
+            size_type n_results = 0;
+            search(0, t, sink, n_results, start, limit_results, timeout_seconds);
+            return n_results;
+        };
+
+
+        /**
+         * Counts the results of the join without enumerating all of them. The GAO ends with the variables
+         * that appear in only one triple pattern; once the other variables are bound, the bindings of those
+         * variables are the triples in the intervals of their iterators, so each iterator multiplies the
+         * count by the size of its interval. Repeated triples of the index are counted once per repeat.
+         *
+         * @param limit_results     Limit of results
+         * @param timeout_seconds   Timeout in seconds
+         * @return                  Number of results, at most limit_results if there is a limit
+         */
+        size_type join_count(const size_type limit_results = 0, const size_type timeout_seconds = 0){
+            if(m_is_empty) return 0;
+            time_point_type start = std::chrono::high_resolution_clock::now();
+
+            //Variables at the end of the GAO with only one iterator, and their iterators
+            size_type lonely_start = m_gao.size();
+            while(lonely_start > 0 && m_var_to_iterators[m_gao[lonely_start-1]].size() == 1){
+                --lonely_start;
+            }
+            std::vector<ltj_iter_type*> lonely_iterators;
+            for(size_type j = lonely_start; j < m_gao.size(); ++j){
+                ltj_iter_type* iter = m_var_to_iterators[m_gao[j]][0];
+                if(std::find(lonely_iterators.begin(), lonely_iterators.end(), iter) == lonely_iterators.end()){
+                    lonely_iterators.push_back(iter);
+                }
+            }
+
+            size_type n_results = 0;
+            count(0, lonely_start, lonely_iterators, n_results, start, limit_results, timeout_seconds);
+            if(limit_results > 0 && n_results > limit_results) return limit_results;
+            return n_results;
+        };
+
+        /**
+         * Join that runs on several threads. The subtrees of the first variables of the GAO are split into
+         * tasks, each one with its own copy of the iterators, and idle threads steal them. The tasks share
+         * the ring, which is only read and must have been set with ring::set_concurrent_select. The results
+         * are the same as those of join, in a different order; with a limit, any limit_results of them.
+         *
+         * @param res               Results
+         * @param n_threads         Number of threads
+         * @param limit_results     Limit of results
+         * @param timeout_seconds   Timeout in seconds
+         */
+        void join_parallel(std::vector<tuple_type> &res, const size_type n_threads,
+                           const size_type limit_results = 0, const size_type timeout_seconds = 0){
+            join_parallel_stream([&res](const tuple_type &t){
+                res.emplace_back(t);
+                return true;
+            }, n_threads, limit_results, timeout_seconds);
+        };
+
+        /**
+         * Parallel join that reports each result to a sink (see join_stream). The calls to the sink are
+         * made from several threads, one at a time.
+         *
+         * @param sink              Called as sink(const tuple_type &) for each result
+         * @param n_threads         Number of threads
+         * @param limit_results     Limit of results
+         * @param timeout_seconds   Timeout in seconds
+         * @return                  Number of results
+         */
+        template<class t_sink>
+        size_type join_parallel_stream(t_sink &&sink, const size_type n_threads,
+                                       const size_type limit_results = 0, const size_type timeout_seconds = 0){
+            if(m_is_empty) return 0;
+            if(n_threads <= 1){
+                return join_stream(sink, limit_results, timeout_seconds);
+            }
+            if(!m_ptr_ring->concurrent_select()){
+                throw std::logic_error("A parallel join needs a ring with set_concurrent_select(true)");
+            }
+            parallel_state_type state(n_threads);
+            state.sink = std::ref(sink);
+            state.start = std::chrono::high_resolution_clock::now();
+            state.limit_results = limit_results;
+            state.timeout_seconds = timeout_seconds;
+            state.pool.push(0, [this, &state](const uint64_t thread){
+                tuple_type t(m_gao.size());
+                search_parallel(0, t, state, thread);
+            });
+            state.pool.run();
+            m_n_leaps += state.n_leaps;
+            return state.n_results;
         };
 
 
@@ -170,12 +543,14 @@ namespace ring {
          *
          * @param j                 Index of the variable
          * @param tuple             Tuple of the current search
-         * @param res               Results
+         * @param sink              Sink of the results
+         * @param n_results         Number of results reported
          * @param start             Initial time to check timeout
          * @param limit_results     Limit of results
          * @param timeout_seconds   Timeout in seconds
          */
-        bool search(const size_type j, tuple_type &tuple, std::vector<tuple_type> &res,
+        template<class t_sink>
+        bool search(const size_type j, tuple_type &tuple, t_sink &sink, size_type &n_results,
                     const time_point_type start,
                     const size_type limit_results = 0, const size_type timeout_seconds = 0){
 
@@ -187,48 +562,47 @@ namespace ring {
             }
 
             //(Optional) Check limit
-            if(limit_results > 0 && res.size() == limit_results) return false;
+            if(limit_results > 0 && n_results == limit_results) return false;
 
             if(j == m_gao.size()){
                 //Report results
-                res.emplace_back(tuple);
+                if(!sink((const tuple_type &) tuple)) return false;
+                ++n_results;
             }else{
+                if(is_adaptive_level(j)) choose_var(j);
                 var_type x_j = m_gao[j];
-                std::vector<ltj_iter_type*>& itrs = m_var_to_iterators[x_j];
+                const level_type &level = m_levels[j];
                 bool ok;
-                if(itrs.size() == 1 && itrs[0]->in_last_level()) {//Lonely variables
-                    auto results = itrs[0]->seek_all(x_j);
+                if(level.lonely) {//Lonely variables
+                    const step_type &step = level.steps[0];
+                    auto results = step.iter->all_values(step.state);
                     //std::cout << "Results: " << results.size() << std::endl;
                     for (const auto &c : results) {
                         //1. Adding result to tuple
                         tuple[j] = {x_j, c};
                         //2. Going down in the trie by setting x_j = c (\mu(t_i) in paper)
-                        itrs[0]->down(x_j, c);
+                        step.iter->down_to(step.state, c);
                         //2. Search with the next variable x_{j+1}
-                        ok = search(j + 1, tuple, res, start, limit_results, timeout_seconds);
+                        ok = search(j + 1, tuple, sink, n_results, start, limit_results, timeout_seconds);
                         if(!ok) return false;
                         //4. Going up in the trie by removing x_j = c
-                        itrs[0]->up(x_j);
+                        step.iter->up_from(step.state);
                     }
                 }else {
-                    value_type c = seek(x_j);
+                    value_type c = seek_level(j);
                     //std::cout << "Seek (init): (" << (uint64_t) x_j << ": " << c << ")" <<std::endl;
                     while (c != 0) { //If empty c=0
                         //1. Adding result to tuple
                         tuple[j] = {x_j, c};
                         //2. Going down in the tries by setting x_j = c (\mu(t_i) in paper)
-                        for (ltj_iter_type* iter : itrs) {
-                            iter->down(x_j, c);
-                        }
+                        down_level(j, c);
                         //3. Search with the next variable x_{j+1}
-                        ok = search(j + 1, tuple, res, start, limit_results, timeout_seconds);
+                        ok = search(j + 1, tuple, sink, n_results, start, limit_results, timeout_seconds);
                         if(!ok) return false;
                         //4. Going up in the tries by removing x_j = c
-                        for (ltj_iter_type *iter : itrs) {
-                            iter->up(x_j);
-                        }
+                        up_level(j);
                         //5. Next constant for x_j
-                        c = seek(x_j, c + 1);
+                        c = seek_level(j, c + 1);
                         //std::cout << "Seek (bucle): (" << (uint64_t) x_j << ": " << c << ")" <<std::endl;
                     }
                 }
@@ -238,33 +612,225 @@ namespace ring {
 
 
         /**
+         * Search of join_count.
+         *
+         * @param j                 Index of the variable
+         * @param lonely_start      Index of the first variable that is counted instead of enumerated
+         * @param lonely_iterators  Iterators of the counted variables
+         * @param n_results         Number of results
+         * @param start             Initial time to check timeout
+         * @param limit_results     Limit of results
+         * @param timeout_seconds   Timeout in seconds
+         */
+        bool count(const size_type j, const size_type lonely_start,
+                   const std::vector<ltj_iter_type*> &lonely_iterators, size_type &n_results,
+                   const time_point_type start,
+                   const size_type limit_results = 0, const size_type timeout_seconds = 0){
+
+            //(Optional) Check timeout
+            if(timeout_seconds > 0){
+                time_point_type stop = std::chrono::high_resolution_clock::now();
+                auto sec = std::chrono::duration_cast<std::chrono::seconds>(stop-start).count();
+                if(static_cast<size_type>(sec) > timeout_seconds) return false;
+            }
+
+            //(Optional) Check limit
+            if(limit_results > 0 && n_results >= limit_results) return false;
+
+            if(j == lonely_start){
+                //Product of the sizes of the intervals
+                size_type c = 1;
+                for(const ltj_iter_type* iter : lonely_iterators){
+                    c *= util::get_size_interval(*iter);
+                }
+                n_results += c;
+            }else{
+                if(is_adaptive_level(j)) choose_var(j);
+                bool ok;
+                value_type c = seek_level(j);
+                while (c != 0) { //If empty c=0
+                    down_level(j, c);
+                    ok = count(j + 1, lonely_start, lonely_iterators, n_results, start,
+                               limit_results, timeout_seconds);
+                    if(!ok) return false;
+                    up_level(j);
+                    c = seek_level(j, c + 1);
+                }
+            }
+            return true;
+        };
+
+
+        /**
+         * Search of join_parallel. While other threads are waiting for work, the subtrees of the first
+         * parallel_levels variables are added to the pool instead of being searched.
          *
-         * @param x_j   Variable
-         * @param c     Constant. If it is unknown the value is -1
-         * @return      The next constant that matches the intersection between the triples of x_j.
-         *              If the intersection is empty, it returns 0.
+         * @param j         Index of the variable
+         * @param tuple     Tuple of the current search
+         * @param state     State shared by the tasks
+         * @param thread    Thread running the search
          */
+        bool search_parallel(const size_type j, tuple_type &tuple, parallel_state_type &state,
+                             const size_type thread){
 
-        value_type seek(const var_type x_j, value_type c=-1){
-            value_type c_i, c_min = UINT64_MAX, c_max = 0;
-            std::vector<ltj_iter_type*>& itrs = m_var_to_iterators[x_j];
-            while (true){
-                //Compute leap for each triple that contains x_j
-                for(ltj_iter_type* iter : itrs){
-                    if(c == -1){
-                        c_i = iter->leap(x_j);
-                    }else{
-                        c_i = iter->leap(x_j, c);
+            if(state.stop) return false;
+
+            //(Optional) Check timeout
+            if(state.timeout_seconds > 0){
+                time_point_type stop = std::chrono::high_resolution_clock::now();
+                auto sec = std::chrono::duration_cast<std::chrono::seconds>(stop-state.start).count();
+                if(static_cast<size_type>(sec) > state.timeout_seconds){
+                    state.stop = true;
+                    return false;
+                }
+            }
+
+            if(j == m_gao.size()){
+                std::lock_guard<std::mutex> lock(state.sink_mutex);
+                //(Optional) Check limit
+                if(state.stop || (state.limit_results > 0 && state.n_results == state.limit_results)){
+                    state.stop = true;
+                    return false;
+                }
+                //Report results
+                if(!state.sink((const tuple_type &) tuple)){
+                    state.stop = true;
+                    return false;
+                }
+                ++state.n_results;
+            }else{
+                if(is_adaptive_level(j)) choose_var(j);
+                var_type x_j = m_gao[j];
+                const level_type &level = m_levels[j];
+                bool split = j < parallel_levels && j + 1 < m_gao.size();
+                bool ok;
+                if(level.lonely) {//Lonely variables
+                    const step_type &step = level.steps[0];
+                    auto results = step.iter->all_values(step.state);
+                    for (const auto &c : results) {
+                        tuple[j] = {x_j, c};
+                        if(split && state.pool.starving()){
+                            push_task(j, c, tuple, state, thread);
+                            continue;
+                        }
+                        step.iter->down_to(step.state, c);
+                        ok = search_parallel(j + 1, tuple, state, thread);
+                        if(!ok) return false;
+                        step.iter->up_from(step.state);
                     }
-                    if(c_i == 0) {
-                        return 0; //Empty intersection
+                }else {
+                    value_type c = seek_level(j);
+                    while (c != 0) { //If empty c=0
+                        tuple[j] = {x_j, c};
+                        if(split && state.pool.starving()){
+                            push_task(j, c, tuple, state, thread);
+                        }else{
+                            down_level(j, c);
+                            ok = search_parallel(j + 1, tuple, state, thread);
+                            if(!ok) return false;
+                            up_level(j);
+                        }
+                        c = seek_level(j, c + 1);
                     }
-                    if(c_i > c_max) c_max = c_i;
-                    if(c_i < c_min) c_min = c_i;
-                    c = c_max;
                 }
-                if(c_min == c_max) return c_min;
-                c_min = UINT64_MAX; c_max = 0;
+            }
+            return true;
+        };
+
+        /**
+         * Adds to the pool the search of the subtree x_j = c, on a copy of the iterators.
+         *
+         * @param j         Index of the variable
+         * @param c         Constant
+         * @param tuple     Tuple of the current search, with x_j = c
+         * @param state     State shared by the tasks
+         * @param thread    Thread adding the task
+         */
+        void push_task(const size_type j, const value_type c, const tuple_type &tuple,
+                       parallel_state_type &state, const size_type thread){
+            ltj_algorithm sub(*this);
+            sub.m_n_leaps = 0;
+            sub.down_level(j, c);
+            tuple_type sub_tuple = tuple;
+            state.pool.push(thread, [sub, sub_tuple, j, &state](const uint64_t t) mutable {
+                sub.search_parallel(j + 1, sub_tuple, state, t);
+                state.n_leaps += sub.n_leaps();
+            });
+        }
+
+
+        /**
+         * Leapfrog over the iterators of the variable at level j of the GAO, with their states at that level.
+         * When the search of the variable starts, the iterators are sorted by the size of their intervals,
+         * so the most selective one gives the first candidate and the others are asked for values >= the
+         * candidate. Each iterator leaps until all of them agree on one value, and an iterator that already
+         * returned the current candidate is not asked again.
+         *
+         * @param j     Index of the variable
+         * @param c     Constant, or unknown when the search of the variable starts
+         * @return      The next constant that matches the intersection, or 0 if it is empty
+         */
+        value_type seek_level(const size_type j, value_type c=unknown){
+            std::vector<step_type>& steps = m_levels[j].steps;
+            size_type n = steps.size(), agree = 0, i = 0;
+            if(c == unknown){
+                std::sort(steps.begin(), steps.end(), [](const step_type &a, const step_type &b){
+                    return util::get_size_interval(*a.iter) < util::get_size_interval(*b.iter);
+                });
+                c = steps[0].iter->leap_min(steps[0].state);
+                ++m_n_leaps;
+                if(c == 0) return 0; //Empty intersection
+                agree = 1;
+                i = 1 % n;
+            }
+            while(agree < n){
+                const step_type &step = steps[i];
+                value_type c_i = step.iter->leap_next(step.state, c);
+                ++m_n_leaps;
+                if(c_i == 0) return 0; //Empty intersection
+                if(c_i == c){
+                    ++agree;
+                }else{
+                    c = c_i;
+                    agree = 1;
+                }
+                i = (i + 1) % n;
+            }
+            return c;
+        }
+
+        //Binds the variable at level j of the GAO to c in its iterators
+        inline void down_level(const size_type j, const value_type c){
+            if(is_adaptive_level(j)){
+                //up only clears the value of the term, and keeps the intervals computed by down. The
+                //intervals of the iterators are only valid for the later variables of a fixed order, so their
+                //bounds are saved and restored by up_level
+                const std::vector<step_type>& steps = m_levels[j].steps;
+                iterator_bounds_type& saved = m_levels[j].saved;
+                saved.resize(steps.size());
+                for(size_type i = 0; i < steps.size(); ++i){
+                    steps[i].iter->save(saved[i]);
+                    steps[i].iter->down_to(steps[i].state, c);
+                }
+                return;
+            }
+            for(const step_type &step : m_levels[j].steps){
+                step.iter->down_to(step.state, c);
+            }
+        }
+
+        //Unbinds the variable at level j of the GAO in its iterators
+        inline void up_level(const size_type j){
+            if(is_adaptive_level(j)){
+                const std::vector<step_type>& steps = m_levels[j].steps;
+                const iterator_bounds_type& saved = m_levels[j].saved;
+                for(size_type i = 0; i < steps.size(); ++i){
+                    steps[i].iter->restore(saved[i]);
+                }
+                return;
+            }
+            for(const step_type &step : m_levels[j].steps){
+                step.iter->up_from(step.state);
             }
         }
 
@@ -20,7 +20,7 @@
 #ifndef RING_LTJ_ITERATOR_HPP
 #define RING_LTJ_ITERATOR_HPP
 
-#define VERBOSE 0
+#include <cassert>
 
 namespace ring {
 
@@ -35,9 +35,13 @@ namespace ring {
         //enum state_type {s, p, o};
         //std::vector<value_type> leap_result_type;
 
+        //Terms of a triple pattern, and their bits in a set of bound terms
+        enum : uint8_t {subject = 0, predicate = 1, object = 2, none = 3};
+        enum : uint8_t {bound_s = 1, bound_p = 2, bound_o = 4};
+
     private:
         const triple_pattern *m_ptr_triple_pattern;
-        ring_type *m_ptr_ring; //TODO: should be const
+        const ring_type *m_ptr_ring;
         bwt_interval m_i_s;
         bwt_interval m_i_p;
         bwt_interval m_i_o;
@@ -45,9 +49,19 @@ namespace ring {
         value_type m_cur_p;
         value_type m_cur_o;
         bool m_is_empty = false;
+        var_type m_var[3]; //variables of the terms, read from the triple pattern once
+        bool m_is_var[3];
         //TODO: ao mellor hai que meter o nivel para saber cando parar de facer down
         //std::stack<state_type> m_states;
 
+        inline bwt_interval &interval(const uint8_t t) {
+            return t == subject ? m_i_s : (t == predicate ? m_i_p : m_i_o);
+        }
+
+        inline value_type &cur(const uint8_t t) {
+            return t == subject ? m_cur_s : (t == predicate ? m_cur_p : m_cur_o);
+        }
+
 
         void copy(const ltj_iterator &o) {
             m_ptr_triple_pattern = o.m_ptr_triple_pattern;
@@ -59,18 +73,8 @@ namespace ring {
             m_cur_p = o.m_cur_p;
             m_cur_o = o.m_cur_o;
             m_is_empty = o.m_is_empty;
-        }
-
-        inline bool is_variable_subject(var_type var) {
-            return m_ptr_triple_pattern->term_s.is_variable && var == m_ptr_triple_pattern->term_s.value;
-        }
-
-        inline bool is_variable_predicate(var_type var) {
-            return m_ptr_triple_pattern->term_p.is_variable && var == m_ptr_triple_pattern->term_p.value;
-        }
-
-        inline bool is_variable_object(var_type var) {
-            return m_ptr_triple_pattern->term_o.is_variable && var == m_ptr_triple_pattern->term_o.value;
+            std::copy(o.m_var, o.m_var + 3, m_var);
+            std::copy(o.m_is_var, o.m_is_var + 3, m_is_var);
         }
 
     public:
@@ -84,9 +88,15 @@ namespace ring {
 
         ltj_iterator() = default;
 
-        ltj_iterator(const triple_pattern *triple, ring_type *ring) {
+        ltj_iterator(const triple_pattern *triple, const ring_type *ring) {
             m_ptr_triple_pattern = triple;
             m_ptr_ring = ring;
+            m_var[subject] = triple->term_s.value;
+            m_var[predicate] = triple->term_p.value;
+            m_var[object] = triple->term_o.value;
+            m_is_var[subject] = triple->s_is_variable();
+            m_is_var[predicate] = triple->p_is_variable();
+            m_is_var[object] = triple->o_is_variable();
             m_cur_s = -1;
             m_cur_p = -1;
             m_cur_o = -1;
@@ -274,6 +284,8 @@ namespace ring {
                 m_cur_p = o.m_cur_p;
                 m_cur_o = o.m_cur_o;
                 m_is_empty = o.m_is_empty;
+                std::copy(o.m_var, o.m_var + 3, m_var);
+                std::copy(o.m_is_var, o.m_is_var + 3, m_is_var);
             }
             return *this;
         }
@@ -289,307 +301,243 @@ namespace ring {
             std::swap(m_cur_p, o.m_cur_p);
             std::swap(m_cur_o, o.m_cur_o);
             std::swap(m_is_empty, o.m_is_empty);
+            std::swap(m_var, o.m_var);
+            std::swap(m_is_var, o.m_is_var);
         }
 
-        void down(var_type var, size_type c) { //Go down in the trie
-            if (is_variable_subject(var)) {
-                if (m_cur_o != -1 && m_cur_p != -1){
-#if VERBOSE
-                    std::cout << "Nothing to do" << std::endl;
-#endif
-                    return;
-                }
-                if (m_cur_o != -1) {
-                    //OS->P
-#if VERBOSE
-                    std::cout << "down_O_S" << std::endl;
-#endif
-                    m_i_p = m_ptr_ring->down_O_S(m_i_s, m_cur_o, c);
-                } else if (m_cur_p != -1) {
-                    //PS->O
-#if VERBOSE
-                    std::cout << "down_P_S" << std::endl;
-#endif
-                    m_i_o = m_ptr_ring->down_P_S(m_i_s, c);
+        //What down_to overwrites: the ranges and stored values of the intervals, and the current values
+        typedef struct {
+            uint64_t l[3];
+            uint64_t r[3];
+            std::pair<uint64_t, uint64_t> stored[3];
+            value_type cur[3];
+        } bounds_type;
+
+        void save(bounds_type &b) const {
+            const bwt_interval *itv[3] = {&m_i_s, &m_i_p, &m_i_o};
+            const value_type values[3] = {m_cur_s, m_cur_p, m_cur_o};
+            for (uint8_t t = 0; t < 3; ++t) {
+                b.l[t] = itv[t]->left();
+                b.r[t] = itv[t]->right();
+                b.stored[t] = itv[t]->get_stored_values();
+                b.cur[t] = values[t];
+            }
+        }
+
+        //Back to the state given by save
+        void restore(const bounds_type &b) {
+            for (uint8_t t = 0; t < 3; ++t) {
+                bwt_interval &itv = interval(t);
+                itv.set_range(b.l[t], b.r[t]);
+                itv.set_stored_values(b.stored[t].first, b.stored[t].second);
+                cur(t) = b.cur[t];
+            }
+        }
+
+        /*
+         * Transitions of the iterator for a variable that is the term t_term of the triple pattern, when the
+         * terms in t_bound (bound_mask(term)) are bound to a constant. The state is known when the query is
+         * built, so ltj_algorithm computes it once with make_state() and the operations on a state below
+         * reach the instantiation through a switch, instead of testing the terms and the current values at
+         * every step. This moves work out of the steps; it has not been shown to make the queries faster.
+         */
+
+        //Smallest value of the term in the range
+        template<uint8_t t_term, uint8_t t_bound>
+        value_type leap_min() {
+            if (t_term == subject) {
+                if (t_bound == (bound_p | bound_o)) return m_ptr_ring->min_S_in_PO(m_i_s);
+                if (t_bound == bound_o) return m_ptr_ring->min_S_in_O(m_i_s, m_cur_o);
+                if (t_bound == bound_p) return m_ptr_ring->min_S_in_P(m_i_s);
+                return m_ptr_ring->min_S(m_i_s);
+            } else if (t_term == predicate) {
+                if (t_bound == (bound_s | bound_o)) return m_ptr_ring->min_P_in_SO(m_i_p);
+                if (t_bound == bound_s) return m_ptr_ring->min_P_in_S(m_i_p, m_cur_s);
+                if (t_bound == bound_o) return m_ptr_ring->min_P_in_O(m_i_p);
+                return m_ptr_ring->min_P(m_i_p);
+            } else {
+                if (t_bound == (bound_s | bound_p)) return m_ptr_ring->min_O_in_SP(m_i_o);
+                if (t_bound == bound_s) return m_ptr_ring->min_O_in_S(m_i_o);
+                if (t_bound == bound_p) return m_ptr_ring->min_O_in_P(m_i_o, m_cur_p);
+                return m_ptr_ring->min_O(m_i_o);
+            }
+        }
+
+        //Next value of the term greater or equal than c in the range
+        template<uint8_t t_term, uint8_t t_bound>
+        value_type leap_next(size_type c) {
+            if (t_term == subject) {
+                if (t_bound == (bound_p | bound_o)) return m_ptr_ring->next_S_in_PO(m_i_s, c);
+                if (t_bound == bound_o) return m_ptr_ring->next_S_in_O(m_i_s, m_cur_o, c);
+                if (t_bound == bound_p) return m_ptr_ring->next_S_in_P(m_i_s, c);
+                return m_ptr_ring->next_S(m_i_s, c);
+            } else if (t_term == predicate) {
+                if (t_bound == (bound_s | bound_o)) return m_ptr_ring->next_P_in_SO(m_i_p, c);
+                if (t_bound == bound_s) return m_ptr_ring->next_P_in_S(m_i_p, m_cur_s, c);
+                if (t_bound == bound_o) return m_ptr_ring->next_P_in_O(m_i_p, c);
+                return m_ptr_ring->next_P(m_i_p, c);
+            } else {
+                if (t_bound == (bound_s | bound_p)) return m_ptr_ring->next_O_in_SP(m_i_o, c);
+                if (t_bound == bound_s) return m_ptr_ring->next_O_in_S(m_i_o, c);
+                if (t_bound == bound_p) return m_ptr_ring->next_O_in_P(m_i_o, m_cur_p, c);
+                return m_ptr_ring->next_O(m_i_o, c);
+            }
+        }
+
+        //Goes down in the trie by binding the term to c
+        template<uint8_t t_term, uint8_t t_bound>
+        void down_to(size_type c) {
+            if (t_term == subject) {
+                if (t_bound == (bound_p | bound_o)) return; //Nothing to do
+                if (t_bound == bound_o) {
+                    m_i_p = m_ptr_ring->down_O_S(m_i_s, m_cur_o, c); //OS->P
+                } else if (t_bound == bound_p) {
+                    m_i_o = m_ptr_ring->down_P_S(m_i_s, c); //PS->O
                 } else {
-                    //S->{OP,PO} same range in SOP and SPO
-#if VERBOSE
-                    std::cout << "down_S" << std::endl;
-#endif
-                    m_i_o = m_i_p = m_ptr_ring->down_S(c);
+                    m_i_o = m_i_p = m_ptr_ring->down_S(c); //S->{OP,PO} same range in SOP and SPO
                 }
-                //m_states.emplace(state_type::s);
                 m_cur_s = c;
-            } else if (is_variable_predicate(var)) {
-                if (m_cur_s != -1 && m_cur_o != -1){
-#if VERBOSE
-                    std::cout << "Nothing to do" << std::endl;
-#endif
-                    return;
-                }
-                if (m_cur_o != -1) {
-                    //OP->S
-#if VERBOSE
-                    std::cout << "down_O_P" << std::endl;
-#endif
-                    m_i_s = m_ptr_ring->down_O_P(m_i_p, c);
-                } else if (m_cur_s != -1) {
-                    //SP->O
-#if VERBOSE
-                    std::cout << "down_S_P" << std::endl;
-#endif
-                    m_i_o = m_ptr_ring->down_S_P(m_i_p, m_cur_s, c);
+            } else if (t_term == predicate) {
+                if (t_bound == (bound_s | bound_o)) return; //Nothing to do
+                if (t_bound == bound_o) {
+                    m_i_s = m_ptr_ring->down_O_P(m_i_p, c); //OP->S
+                } else if (t_bound == bound_s) {
+                    m_i_o = m_ptr_ring->down_S_P(m_i_p, m_cur_s, c); //SP->O
                 } else {
-                    //P->{OS,SO} same range in POS and PSO
-#if VERBOSE
-                    std::cout << "down_P" << std::endl;
-#endif
-                    m_i_o = m_i_s = m_ptr_ring->down_P(c);
+                    m_i_o = m_i_s = m_ptr_ring->down_P(c); //P->{OS,SO} same range in POS and PSO
                 }
-                //m_states.emplace(state_type::p);
                 m_cur_p = c;
-            } else if (is_variable_object(var)) {
-                if (m_cur_s != -1 && m_cur_p != -1){
-#if VERBOSE
-                    std::cout << "Nothing to do" << std::endl;
-#endif
-                    return;
-                }
-                if (m_cur_p != -1) {
-                    //PO->S
-#if VERBOSE
-                    std::cout << "down_P_O" << std::endl;
-#endif
-                    m_i_s = m_ptr_ring->down_P_O(m_i_o, m_cur_p, c);
-                } else if (m_cur_s != -1) {
-                    //SO->P
-#if VERBOSE
-                    std::cout << "down_S_O" << std::endl;
-#endif
-                    m_i_p = m_ptr_ring->down_S_O(m_i_o, c);
+            } else {
+                if (t_bound == (bound_s | bound_p)) return; //Nothing to do
+                if (t_bound == bound_p) {
+                    m_i_s = m_ptr_ring->down_P_O(m_i_o, m_cur_p, c); //PO->S
+                } else if (t_bound == bound_s) {
+                    m_i_p = m_ptr_ring->down_S_O(m_i_o, c); //SO->P
                 } else {
-                    //O->{PS,SP} same range in OPS and OSP
-#if VERBOSE
-                    std::cout << "down_O" << std::endl;
-#endif
-                    m_i_p = m_i_s = m_ptr_ring->down_O(c);
+                    m_i_p = m_i_s = m_ptr_ring->down_O(c); //O->{PS,SP} same range in OPS and OSP
                 }
-                //m_states.emplace(state_type::o);
                 m_cur_o = c;
             }
+        }
 
-        };
-
-
-        void up(var_type var) { //Go up in the trie
-            if (is_variable_subject(var)) {
+        //Goes up in the trie by unbinding the term
+        template<uint8_t t_term>
+        void up_from() {
+            if (t_term == subject) {
                 m_cur_s = -1;
-#if VERBOSE
-                std::cout << "Up in S" << std::endl;
-#endif
-            } else if (is_variable_predicate(var)) {
+            } else if (t_term == predicate) {
                 m_cur_p = -1;
-#if VERBOSE
-                std::cout << "Up in P" << std::endl;
-#endif
-            } else if (is_variable_object(var)) {
+            } else {
                 m_cur_o = -1;
-#if VERBOSE
-                std::cout << "Up in O" << std::endl;
-#endif
             }
+        }
 
-        };
-
-        value_type leap(var_type var) { //Return the minimum in the range
-            //0. Which term of our triple pattern is var
-            if (is_variable_subject(var)) {
-                //1. We have to go down through s
-                if (m_cur_p != -1 && m_cur_o != -1) {
-                    //PO->S
-#if VERBOSE
-                    std::cout << "min_S_in_PO" << std::endl;
-#endif
-                    return m_ptr_ring->min_S_in_PO(m_i_s);
-                } else if (m_cur_o != -1) {
-                    //O->S
-#if VERBOSE
-                    std::cout << "min_S_in_O" << std::endl;
-#endif
-                    return m_ptr_ring->min_S_in_O(m_i_s, m_cur_o);
-                } else if (m_cur_p != -1) {
-                    //P->S
-#if VERBOSE
-                    std::cout << "min_S_in_P" << std::endl;
-#endif
-                    return m_ptr_ring->min_S_in_P(m_i_s);
-                } else {
-                    //S
-#if VERBOSE
-                    std::cout << "min_S" << std::endl;
-#endif
-                    return m_ptr_ring->min_S(m_i_s);
-                }
-            } else if (is_variable_predicate(var)) {
-                //1. We have to go down in the trie of p
-                if (m_cur_s != -1 && m_cur_o != -1) {
-                    //SO->P
-#if VERBOSE
-                    std::cout << "min_P_in_SO" << std::endl;
-#endif
-                    return m_ptr_ring->min_P_in_SO(m_i_p);
-                } else if (m_cur_s != -1) {
-                    //S->P
-#if VERBOSE
-                    std::cout << "min_P_in_S" << std::endl;
-#endif
-                    return m_ptr_ring->min_P_in_S(m_i_p, m_cur_s);
-                } else if (m_cur_o != -1) {
-                    //O->P
-#if VERBOSE
-                    std::cout << "min_P_in_O" << std::endl;
-#endif
-                    return m_ptr_ring->min_P_in_O(m_i_p);
-                } else {
-                    //P
-#if VERBOSE
-                    std::cout << "min_P" << std::endl;
-#endif
-                    return m_ptr_ring->min_P(m_i_p);
-                }
-            } else if (is_variable_object(var)) {
-                //1. We have to go down in the trie of o
-                if (m_cur_s != -1 && m_cur_p != -1) {
-                    //SP->O
-#if VERBOSE
-                    std::cout << "min_O_in_SP" << std::endl;
-#endif
-                    return m_ptr_ring->min_O_in_SP(m_i_o);
-                } else if (m_cur_s != -1) {
-                    //S->O
-#if VERBOSE
-                    std::cout << "min_O_in_S" << std::endl;
-#endif
-                    return m_ptr_ring->min_O_in_S(m_i_o);
-                } else if (m_cur_p != -1) {
-                    //P->O
-#if VERBOSE
-                    std::cout << "min_O_in_P" << std::endl;
-#endif
-                    return m_ptr_ring->min_O_in_P(m_i_o, m_cur_p);
-                } else {
-                    //O
-#if VERBOSE
-                    std::cout << "min_O" << std::endl;
-#endif
-                    return m_ptr_ring->min_O(m_i_o);
-                }
+        //All the values of the term in the range. Only works in the last level
+        template<uint8_t t_term>
+        std::vector<uint64_t> all_values() {
+            if (t_term == subject) return m_ptr_ring->all_S_in_range(m_i_s);
+            if (t_term == predicate) return m_ptr_ring->all_P_in_range(m_i_p);
+            return m_ptr_ring->all_O_in_range(m_i_o);
+        }
+
+        /**
+         * @param term  Term of the triple pattern (subject, predicate or object)
+         * @param bound Terms bound to a constant, without term
+         * @return      State of the iterator for term, for the operations below
+         */
+        static inline uint8_t make_state(const uint8_t term, const uint8_t bound) {
+            return term * 8 + bound;
+        }
+
+        //Any state that make_state does not give for a term of the triple pattern
+        [[noreturn]] static inline void invalid_state() {
+            assert(false && "Invalid state of ltj_iterator");
+            __builtin_unreachable();
+        }
+
+        inline value_type leap_min(const uint8_t state) {
+            switch (state) {
+                case subject * 8: return leap_min<subject, 0>();
+                case subject * 8 + bound_p: return leap_min<subject, bound_p>();
+                case subject * 8 + bound_o: return leap_min<subject, bound_o>();
+                case subject * 8 + (bound_p | bound_o): return leap_min<subject, bound_p | bound_o>();
+                case predicate * 8: return leap_min<predicate, 0>();
+                case predicate * 8 + bound_s: return leap_min<predicate, bound_s>();
+                case predicate * 8 + bound_o: return leap_min<predicate, bound_o>();
+                case predicate * 8 + (bound_s | bound_o): return leap_min<predicate, bound_s | bound_o>();
+                case object * 8: return leap_min<object, 0>();
+                case object * 8 + bound_s: return leap_min<object, bound_s>();
+                case object * 8 + bound_p: return leap_min<object, bound_p>();
+                case object * 8 + (bound_s | bound_p): return leap_min<object, bound_s | bound_p>();
+                default: invalid_state();
             }
-            return 0;
-        };
-
-        value_type leap(var_type var, size_type c) { //Return the next value greater or equal than c in the range
-            //0. Which term of our triple pattern is var
-            if (is_variable_subject(var)) {
-                //1. We have to go down through s
-                if (m_cur_p != -1 && m_cur_o != -1) {
-                    //PO->S
-#if VERBOSE
-                    std::cout << "next_S_in_PO" << std::endl;
-#endif
-                    return m_ptr_ring->next_S_in_PO(m_i_s, c);
-                } else if (m_cur_o != -1) {
-                    //O->S
-#if VERBOSE
-                    std::cout << "next_S_in_O" << std::endl;
-#endif
-                    return m_ptr_ring->next_S_in_O(m_i_s, m_cur_o, c);
-                } else if (m_cur_p != -1) {
-                    //P->S
-#if VERBOSE
-                    std::cout << "next_S_in_P" << std::endl;
-#endif
-                    return m_ptr_ring->next_S_in_P(m_i_s, c);
-                } else {
-                    //S
-#if VERBOSE
-                    std::cout << "next_S" << std::endl;
-#endif
-                    return m_ptr_ring->next_S(m_i_s, c);
-                }
-            } else if (is_variable_predicate(var)) {
-                //1. We have to go down in the trie of p
-                if (m_cur_s != -1 && m_cur_o != -1) {
-                    //SO->P
-#if VERBOSE
-                    std::cout << "next_P_in_SO" << std::endl;
-#endif
-                    return m_ptr_ring->next_P_in_SO(m_i_p, c);
-                } else if (m_cur_s != -1) {
-                    //S->P
-#if VERBOSE
-                    std::cout << "next_P_in_S" << std::endl;
-#endif
-                    return m_ptr_ring->next_P_in_S(m_i_p, m_cur_s, c);
-                } else if (m_cur_o != -1) {
-                    //O->P
-#if VERBOSE
-                    std::cout << "next_P_in_O" << std::endl;
-#endif
-                    return m_ptr_ring->next_P_in_O(m_i_p, c);
-                } else {
-                    //P
-#if VERBOSE
-                    std::cout << "next_P" << std::endl;
-#endif
-                    return m_ptr_ring->next_P(m_i_p, c);
-                }
-            } else if (is_variable_object(var)) {
-                //1. We have to go down in the trie of o
-                if (m_cur_s != -1 && m_cur_p != -1) {
-                    //SP->O
-#if VERBOSE
-                    std::cout << "next_O_in_SP" << std::endl;
-#endif
-                    return m_ptr_ring->next_O_in_SP(m_i_o, c);
-                } else if (m_cur_s != -1) {
-                    //S->O
-#if VERBOSE
-                    std::cout << "next_O_in_S" << std::endl;
-#endif
-                    return m_ptr_ring->next_O_in_S(m_i_o, c);
-                } else if (m_cur_p != -1) {
-                    //P->O
-#if VERBOSE
-                    std::cout << "next_O_in_P" << std::endl;
-#endif
-                    return m_ptr_ring->next_O_in_P(m_i_o, m_cur_p, c);
-                } else {
-                    //O
-#if VERBOSE
-                    std::cout << "next_O" << std::endl;
-#endif
-                    return m_ptr_ring->next_O(m_i_o, c);
-                }
+        }
+
+        inline value_type leap_next(const uint8_t state, size_type c) {
+            switch (state) {
+                case subject * 8: return leap_next<subject, 0>(c);
+                case subject * 8 + bound_p: return leap_next<subject, bound_p>(c);
+                case subject * 8 + bound_o: return leap_next<subject, bound_o>(c);
+                case subject * 8 + (bound_p | bound_o): return leap_next<subject, bound_p | bound_o>(c);
+                case predicate * 8: return leap_next<predicate, 0>(c);
+                case predicate * 8 + bound_s: return leap_next<predicate, bound_s>(c);
+                case predicate * 8 + bound_o: return leap_next<predicate, bound_o>(c);
+                case predicate * 8 + (bound_s | bound_o): return leap_next<predicate, bound_s | bound_o>(c);
+                case object * 8: return leap_next<object, 0>(c);
+                case object * 8 + bound_s: return leap_next<object, bound_s>(c);
+                case object * 8 + bound_p: return leap_next<object, bound_p>(c);
+                case object * 8 + (bound_s | bound_p): return leap_next<object, bound_s | bound_p>(c);
+                default: invalid_state();
             }
-            return 0;
         }
 
-        bool in_last_level(){
-            return (m_cur_o !=-1 && m_cur_p != -1) || (m_cur_s !=-1 && m_cur_p != -1)
-                    || (m_cur_o !=-1 && m_cur_s != -1);
+        inline void down_to(const uint8_t state, size_type c) {
+            switch (state) {
+                case subject * 8: down_to<subject, 0>(c); break;
+                case subject * 8 + bound_p: down_to<subject, bound_p>(c); break;
+                case subject * 8 + bound_o: down_to<subject, bound_o>(c); break;
+                case subject * 8 + (bound_p | bound_o): down_to<subject, bound_p | bound_o>(c); break;
+                case predicate * 8: down_to<predicate, 0>(c); break;
+                case predicate * 8 + bound_s: down_to<predicate, bound_s>(c); break;
+                case predicate * 8 + bound_o: down_to<predicate, bound_o>(c); break;
+                case predicate * 8 + (bound_s | bound_o): down_to<predicate, bound_s | bound_o>(c); break;
+                case object * 8: down_to<object, 0>(c); break;
+                case object * 8 + bound_s: down_to<object, bound_s>(c); break;
+                case object * 8 + bound_p: down_to<object, bound_p>(c); break;
+                case object * 8 + (bound_s | bound_p): down_to<object, bound_s | bound_p>(c); break;
+                default: invalid_state();
+            }
         }
 
-        //Solo funciona en último nivel, en otro caso habría que reajustar
-        std::vector<uint64_t> seek_all(var_type var){
-            if (is_variable_subject(var)){
-                return m_ptr_ring->all_S_in_range(m_i_s);
-            }else if (is_variable_predicate(var)){
-                return m_ptr_ring->all_P_in_range(m_i_p);
-            }else if (is_variable_object(var)){
-                return m_ptr_ring->all_O_in_range(m_i_o);
+        inline void up_from(const uint8_t state) {
+            switch (state / 8) {
+                case subject: up_from<subject>(); break;
+                case predicate: up_from<predicate>(); break;
+                case object: up_from<object>(); break;
+                default: invalid_state();
             }
-            return std::vector<uint64_t>();
+        }
+
+        inline std::vector<uint64_t> all_values(const uint8_t state) {
+            switch (state / 8) {
+                case subject: return all_values<subject>();
+                case predicate: return all_values<predicate>();
+                case object: return all_values<object>();
+                default: invalid_state();
+            }
+        }
+
+        //Term of the triple pattern that is var, or none
+        inline uint8_t term(var_type var) const {
+            if (m_is_var[subject] && m_var[subject] == var) return subject;
+            if (m_is_var[predicate] && m_var[predicate] == var) return predicate;
+            if (m_is_var[object] && m_var[object] == var) return object;
+            return none;
+        }
+
+        //Terms bound to a constant in the current state
+        inline uint8_t bound_mask() const {
+            return (m_cur_s != -1 ? bound_s : 0) | (m_cur_p != -1 ? bound_p : 0) | (m_cur_o != -1 ? bound_o : 0);
         }
     };
 
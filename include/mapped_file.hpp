@@ -0,0 +1,92 @@
+/*
+ * mapped_file.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_MAPPED_FILE_HPP
+#define RING_MAPPED_FILE_HPP
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ring {
+
+    //Read-only memory mapping of a file. The pages are read on demand and shared with the page cache
+    class mapped_file {
+
+    private:
+        const char *m_data = nullptr;
+        uint64_t m_size = 0;
+
+    public:
+        /**
+         * @param file      File to map
+         * @param advice    Expected access pattern, given to madvise
+         */
+        mapped_file(const std::string &file, const int advice = MADV_NORMAL) {
+            int fd = ::open(file.c_str(), O_RDONLY);
+            if (fd < 0) throw std::runtime_error("Cannot open " + file);
+            struct stat st;
+            if (::fstat(fd, &st) < 0) {
+                ::close(fd);
+                throw std::runtime_error("Cannot stat " + file);
+            }
+            m_size = st.st_size;
+            if (m_size > 0) {
+                void *p = ::mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (p == MAP_FAILED) {
+                    ::close(fd);
+                    throw std::runtime_error("Cannot map " + file);
+                }
+                ::madvise(p, m_size, advice);
+                m_data = (const char *) p;
+            }
+            ::close(fd);
+        }
+
+        mapped_file(const mapped_file &) = delete;
+        mapped_file &operator=(const mapped_file &) = delete;
+
+        ~mapped_file() {
+            if (m_data != nullptr) ::munmap((void *) m_data, m_size);
+        }
+
+        inline const char *data() const {
+            return m_data;
+        }
+
+        inline uint64_t size() const {
+            return m_size;
+        }
+
+        //Drops the pages of [begin, end) from the memory of the process; they are read again if accessed
+        void release(uint64_t begin, uint64_t end) const {
+            uint64_t page = ::sysconf(_SC_PAGESIZE);
+            begin = begin / page * page;
+            end = std::min(end, m_size) / page * page;
+            if (m_data != nullptr && begin < end) ::madvise((void *) (m_data + begin), end - begin, MADV_DONTNEED);
+        }
+    };
+}
+
+#endif //RING_MAPPED_FILE_HPP
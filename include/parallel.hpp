@@ -0,0 +1,186 @@
+/*
+ * parallel.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_PARALLEL_HPP
+#define RING_PARALLEL_HPP
+
+#include <atomic>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+
+namespace ring {
+
+    namespace parallel {
+
+        typedef std::function<void()> task_type;
+
+        /**
+         * Runs the tasks using at most n_threads threads (the calling thread included).
+         * Tasks are started in the order they are given.
+         *
+         * @param tasks         Tasks to run
+         * @param n_threads     Maximum number of threads
+         */
+        inline void run_tasks(std::vector<task_type> &tasks, const uint64_t n_threads) {
+            if (n_threads <= 1 || tasks.size() <= 1) {
+                for (auto &task : tasks) task();
+                return;
+            }
+            std::atomic<uint64_t> next(0);
+            auto worker = [&tasks, &next]() {
+                uint64_t i;
+                while ((i = next++) < tasks.size()) {
+                    tasks[i]();
+                }
+            };
+            uint64_t n = std::min<uint64_t>(n_threads, tasks.size());
+            std::vector<std::thread> threads;
+            threads.reserve(n - 1);
+            for (uint64_t i = 1; i < n; ++i) {
+                threads.emplace_back(worker);
+            }
+            worker();
+            for (auto &t : threads) {
+                t.join();
+            }
+        }
+
+        /*
+         * Pool of threads with a deque of tasks per thread. Each thread runs the newest task of its own
+         * deque; when the deque is empty it steals the oldest task of another thread, which is usually
+         * the largest one. Tasks may add new tasks while they run. A thread that finds no task sleeps until a
+         * task is added or the last one ends.
+         */
+        class work_stealing_pool {
+
+        public:
+            typedef std::function<void(uint64_t)> task_type; //receives the id of the thread running it
+
+        private:
+            struct queue_type {
+                std::mutex mutex;
+                std::deque<task_type> tasks;
+            };
+
+            std::vector<queue_type> m_queues;
+            std::atomic<uint64_t> m_pending; //tasks added and not finished yet
+            std::atomic<uint64_t> m_queued;  //tasks waiting in the deques
+            std::mutex m_idle_mutex;
+            std::condition_variable m_idle;  //signalled when a task is added and when m_pending reaches 0
+
+            bool pop(const uint64_t id, task_type &task) {
+                std::lock_guard<std::mutex> lock(m_queues[id].mutex);
+                if (m_queues[id].tasks.empty()) return false;
+                task = std::move(m_queues[id].tasks.back());
+                m_queues[id].tasks.pop_back();
+                --m_queued;
+                return true;
+            }
+
+            bool steal(const uint64_t id, task_type &task) {
+                for (uint64_t k = 1; k < m_queues.size(); ++k) {
+                    queue_type &q = m_queues[(id + k) % m_queues.size()];
+                    std::lock_guard<std::mutex> lock(q.mutex);
+                    if (q.tasks.empty()) continue;
+                    task = std::move(q.tasks.front());
+                    q.tasks.pop_front();
+                    --m_queued;
+                    return true;
+                }
+                return false;
+            }
+
+            //Wakes one sleeping thread, or all of them. Taking the mutex orders the change of the counters before
+            //the check of a thread that is about to sleep
+            void wake(const bool all) {
+                {
+                    std::lock_guard<std::mutex> lock(m_idle_mutex);
+                }
+                if (all) m_idle.notify_all(); else m_idle.notify_one();
+            }
+
+            void worker(const uint64_t id) {
+                task_type task;
+                while (true) {
+                    if (pop(id, task) || steal(id, task)) {
+                        task(id);
+                        task = nullptr;
+                        if (--m_pending == 0) wake(true);
+                    } else {
+                        std::unique_lock<std::mutex> lock(m_idle_mutex);
+                        m_idle.wait(lock, [this]() { return m_queued > 0 || m_pending == 0; });
+                        if (m_pending == 0) return;
+                    }
+                }
+            }
+
+        public:
+            work_stealing_pool(const uint64_t n_threads)
+                    : m_queues(std::max<uint64_t>(n_threads, 1)), m_pending(0), m_queued(0) {}
+
+            work_stealing_pool(const work_stealing_pool &) = delete;
+            work_stealing_pool &operator=(const work_stealing_pool &) = delete;
+
+            inline uint64_t size() const {
+                return m_queues.size();
+            }
+
+            //True when there are fewer waiting tasks than threads, so new tasks would not wait
+            inline bool starving() const {
+                return m_queued < m_queues.size();
+            }
+
+            /**
+             * Adds a task to the deque of a thread.
+             *
+             * @param id    Thread adding the task (0 before run)
+             * @param task  Task
+             */
+            void push(const uint64_t id, task_type task) {
+                ++m_pending;
+                {
+                    std::lock_guard<std::mutex> lock(m_queues[id].mutex);
+                    m_queues[id].tasks.push_back(std::move(task));
+                    ++m_queued;
+                }
+                wake(false);
+            }
+
+            //Runs the tasks in the calling thread (id 0) and size()-1 new threads, until all are done
+            void run() {
+                std::vector<std::thread> threads;
+                threads.reserve(m_queues.size() - 1);
+                for (uint64_t i = 1; i < m_queues.size(); ++i) {
+                    threads.emplace_back(&work_stealing_pool::worker, this, i);
+                }
+                worker(0);
+                for (auto &t : threads) {
+                    t.join();
+                }
+            }
+        };
+    }
+}
+
+#endif //RING_PARALLEL_HPP
@@ -0,0 +1,168 @@
+/*
+ * plan_cache.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RING_PLAN_CACHE_HPP
+#define RING_PLAN_CACHE_HPP
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <triple_pattern.hpp>
+
+namespace ring {
+
+    /*
+     * Plans of the queries already run, keyed by the shape of their triple patterns: the variables are
+     * renumbered by their first occurrence, and each constant is replaced by a marker followed by the size
+     * class (size_class) of the number of triples that match the constants of its triple pattern. A plan is
+     * the GAO and the table of levels of ltj_algorithm: for each variable of the GAO, the triple patterns
+     * whose iterators take part in it and their states. A query with the same shape as a previous one takes
+     * its plan instead of computing it, so its constants only lead to another order when they fall in
+     * another size class. It can be shared by the threads of a query_executor.
+     */
+    template<class var_t = uint8_t>
+    class plan_cache {
+
+    public:
+        typedef var_t var_type;
+        typedef uint64_t size_type;
+
+        //Iterator of the triple pattern `pattern` with its state (ltj_iterator::make_state)
+        typedef struct {
+            size_type pattern;
+            uint8_t state;
+        } step_type;
+
+        typedef struct {
+            std::vector<var_type> gao;
+            std::vector<std::vector<step_type>> steps; //steps[j] for the variable gao[j]
+            std::vector<bool> lonely; //lonely[j]: only one iterator, which is in its last level
+        } plan_type;
+
+    private:
+        std::unordered_map<std::string, plan_type> m_plans;
+        mutable std::mutex m_mutex;
+        mutable std::atomic<size_type> m_hits{0};
+        mutable std::atomic<size_type> m_misses{0};
+
+        /**
+         * @param query     Triple patterns
+         * @param sizes     Triples that match the constants of each triple pattern
+         * @param vars      Variables of the query, by their number in the key
+         * @return          Key of the shape of the query
+         */
+        static std::string key(const std::vector<triple_pattern> &query, const std::vector<size_type> &sizes,
+                               std::vector<var_type> &vars) {
+            std::string res;
+            auto add_term = [&](const term_pattern &term, const size_type size) {
+                if (!term.is_variable) {
+                    res += 'c';
+                    res += std::to_string(size_class(size));
+                    return;
+                }
+                var_type v = (var_type) term.value;
+                size_type i = 0;
+                while (i < vars.size() && vars[i] != v) ++i;
+                if (i == vars.size()) vars.push_back(v);
+                res += 'v';
+                res += std::to_string(i);
+            };
+            for (size_type i = 0; i < query.size(); ++i) {
+                add_term(query[i].term_s, sizes[i]);
+                add_term(query[i].term_p, sizes[i]);
+                add_term(query[i].term_o, sizes[i]);
+                res += '.';
+            }
+            return res;
+        }
+
+    public:
+        plan_cache() = default;
+
+        plan_cache(const plan_cache &) = delete;
+        plan_cache &operator=(const plan_cache &) = delete;
+
+        //Class of a number of triples: 0 for none, otherwise 1 + floor(log4(n))
+        static size_type size_class(const size_type n) {
+            return n == 0 ? 0 : 1 + (63 - __builtin_clzll(n)) / 2;
+        }
+
+        /**
+         * @param query     Triple patterns
+         * @param sizes     Triples that match the constants of each triple pattern
+         * @param plan      Plan of a previous query with the same shape, in the variables of query
+         * @return          True if there was such a query
+         */
+        bool find(const std::vector<triple_pattern> &query, const std::vector<size_type> &sizes,
+                  plan_type &plan) const {
+            std::vector<var_type> vars;
+            std::string k = key(query, sizes, vars);
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                auto it = m_plans.find(k);
+                if (it == m_plans.end()) {
+                    ++m_misses;
+                    return false;
+                }
+                plan = it->second;
+            }
+            for (var_type &v : plan.gao) v = vars[v];
+            ++m_hits;
+            return true;
+        }
+
+        /**
+         * @param query     Triple patterns
+         * @param sizes     Triples that match the constants of each triple pattern
+         * @param plan      Plan chosen for query
+         */
+        void insert(const std::vector<triple_pattern> &query, const std::vector<size_type> &sizes,
+                    const plan_type &plan) {
+            std::vector<var_type> vars;
+            std::string k = key(query, sizes, vars);
+            plan_type shape = plan;
+            for (var_type &v : shape.gao) {
+                size_type i = 0;
+                while (i < vars.size() && vars[i] != v) ++i;
+                v = (var_type) i;
+            }
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_plans.emplace(k, std::move(shape));
+        }
+
+        size_type size() const {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_plans.size();
+        }
+
+        //Queries that found the plan of a previous query
+        size_type hits() const {
+            return m_hits;
+        }
+
+        size_type misses() const {
+            return m_misses;
+        }
+    };
+}
+
+#endif //RING_PLAN_CACHE_HPP
@@ -0,0 +1,188 @@
+/*
+ * prepared_query.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RING_PREPARED_QUERY_HPP
+#define RING_PREPARED_QUERY_HPP
+
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ltj_algorithm.hpp>
+#include <query_parser.hpp>
+
+namespace ring {
+
+    /*
+     * Query parsed once whose constants may be parameters ($name), run for batches of values of the
+     * parameters. The triple patterns, the iterators, the GAO and the transitions are kept between runs:
+     * only the iterators of the triple patterns with parameters are built again, in place, over the new
+     * values; the others are restored to the bounds they had when the query was planned. The GAO is
+     * the one chosen for the first values whose join is not empty.
+     */
+    template<class ring_t = ring<>>
+    class prepared_query {
+
+    public:
+        typedef ring_t ring_type;
+        typedef uint64_t size_type;
+        typedef ltj_algorithm<ring_type> algorithm_type;
+        typedef typename algorithm_type::tuple_type tuple_type;
+        typedef std::vector<uint64_t> binding_type; //value of each parameter, by first occurrence
+
+    private:
+        const ring_type *m_ptr_ring;
+        std::vector<triple_pattern> m_query;
+        std::vector<query_parser::parameter_slot> m_slots;
+        std::unordered_map<std::string, uint8_t> m_vars;
+        std::unordered_map<std::string, uint64_t> m_params;
+        algorithm_type m_algorithm;
+        bool m_planned = false; //m_algorithm has the iterators, the GAO and the transitions of m_query
+        std::vector<bool> m_has_param; //triple patterns with a parameter, whose iterators are built again
+        typename algorithm_type::iterator_bounds_type m_initial; //bounds of the iterators when they were planned
+
+        void bind(const binding_type &values) {
+            for (const auto &slot : m_slots) {
+                triple_pattern &triple = m_query[slot.pattern];
+                uint64_t v = values[slot.param];
+                if (slot.term == 0) triple.const_s(v);
+                else if (slot.term == 1) triple.const_p(v);
+                else triple.const_o(v);
+            }
+        }
+
+        //Prepares the algorithm for the values in m_query; false if the join is empty
+        bool start() {
+            if (m_planned) return m_algorithm.rebind(m_has_param, m_initial);
+            algorithm_type ltj(&m_query, m_ptr_ring);
+            if (ltj.is_empty()) return false; //the iterators were not built: not planned
+            m_algorithm = std::move(ltj);
+            m_algorithm.save_bounds(m_initial);
+            m_planned = true;
+            return true;
+        }
+
+        //Every binding must have one value per parameter; checked before any of them runs
+        void check(const std::vector<binding_type> &bindings) const {
+            for (size_type i = 0; i < bindings.size(); ++i) {
+                if (bindings[i].size() != m_params.size()) {
+                    throw std::invalid_argument("Binding " + std::to_string(i) + " has " +
+                                                std::to_string(bindings[i].size()) + " values, the query has " +
+                                                std::to_string(m_params.size()) + " parameters");
+                }
+            }
+        }
+
+        //Positions of the bindings sorted by their values, so consecutive runs visit close parts of the index
+        static std::vector<size_type> sorted_order(const std::vector<binding_type> &bindings) {
+            std::vector<size_type> order(bindings.size());
+            std::iota(order.begin(), order.end(), 0);
+            std::stable_sort(order.begin(), order.end(), [&bindings](size_type a, size_type b) {
+                return bindings[a] < bindings[b];
+            });
+            return order;
+        }
+
+    public:
+        /**
+         * @param query_string  Query, with parameters $name in place of constants
+         * @param ring          Ring
+         */
+        prepared_query(const std::string &query_string, const ring_type *ring) : m_ptr_ring(ring) {
+            query_parser::get_prepared_query(query_string, m_query, m_vars, m_params, m_slots);
+            m_has_param.assign(m_query.size(), false);
+            for (const auto &slot : m_slots) m_has_param[slot.pattern] = true;
+        }
+
+        //The algorithm points to m_query
+        prepared_query(const prepared_query &) = delete;
+        prepared_query &operator=(const prepared_query &) = delete;
+
+        inline size_type n_parameters() const {
+            return m_params.size();
+        }
+
+        //Names of the variables, by their identifier in the tuples
+        std::vector<std::string> variable_names() const {
+            std::vector<std::string> names(m_vars.size());
+            for (const auto &v : m_vars) names[v.second] = v.first;
+            return names;
+        }
+
+        //Names of the parameters, by their position in a binding
+        std::vector<std::string> parameter_names() const {
+            std::vector<std::string> names(m_params.size());
+            for (const auto &p : m_params) names[p.second] = p.first;
+            return names;
+        }
+
+        /**
+         * Runs the query for each binding of the parameters. The bindings are run in increasing order of
+         * their values.
+         *
+         * @param bindings          Values of the parameters
+         * @param sink              Called as sink(i, const tuple_type &) for each result of bindings[i]. The
+         *                          run of the binding stops when it returns false
+         * @param limit_results     Limit of results of each binding
+         * @param timeout_seconds   Timeout of each binding in seconds
+         * @return                  Number of results of each binding
+         * @throws std::invalid_argument if a binding does not have one value per parameter
+         */
+        template<class t_sink>
+        std::vector<size_type> execute(const std::vector<binding_type> &bindings, t_sink &&sink,
+                                       const size_type limit_results = 0, const size_type timeout_seconds = 0) {
+            check(bindings);
+            std::vector<size_type> n_results(bindings.size(), 0);
+            for (size_type i : sorted_order(bindings)) {
+                bind(bindings[i]);
+                if (!start()) continue;
+                n_results[i] = m_algorithm.join_stream([&sink, i](const tuple_type &t) {
+                    return sink(i, t);
+                }, limit_results, timeout_seconds);
+            }
+            return n_results;
+        }
+
+        /**
+         * Counts the results of the query for each binding of the parameters (see ltj_algorithm::join_count).
+         *
+         * @param bindings          Values of the parameters
+         * @param limit_results     Limit of results of each binding
+         * @param timeout_seconds   Timeout of each binding in seconds
+         * @return                  Number of results of each binding
+         * @throws std::invalid_argument if a binding does not have one value per parameter
+         */
+        std::vector<size_type> count(const std::vector<binding_type> &bindings,
+                                     const size_type limit_results = 0, const size_type timeout_seconds = 0) {
+            check(bindings);
+            std::vector<size_type> n_results(bindings.size(), 0);
+            for (size_type i : sorted_order(bindings)) {
+                bind(bindings[i]);
+                if (!start()) continue;
+                n_results[i] = m_algorithm.join_count(limit_results, timeout_seconds);
+            }
+            return n_results;
+        }
+    };
+}
+
+#endif //RING_PREPARED_QUERY_HPP
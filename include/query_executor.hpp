@@ -0,0 +1,208 @@
+/*
+ * query_executor.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_QUERY_EXECUTOR_HPP
+#define RING_QUERY_EXECUTOR_HPP
+
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <ltj_algorithm.hpp>
+#include <parallel.hpp>
+#include <plan_cache.hpp>
+#include <query_parser.hpp>
+
+namespace ring {
+
+    typedef struct {
+        uint64_t n_results;
+        uint64_t time_ns; //from the construction of the iterators to the end of the join
+        uint64_t n_leaps; //calls to leap of the join (see ltj_algorithm::n_leaps)
+    } query_stats_type;
+
+    /*
+     * Runs independent queries over one ring shared by several threads. The ring is only read: every
+     * query has its own iterators and intervals, so any number of them can run at the same time. With
+     * several threads the ring must have been set with ring::set_concurrent_select, so its selects keep
+     * their path on the stack instead of in the mutable buffers of wm_int.
+     */
+    template<class ring_t = ring<>>
+    class query_executor {
+
+    public:
+        typedef ring_t ring_type;
+        typedef uint64_t size_type;
+        typedef ltj_algorithm<ring_type> algorithm_type;
+        typedef typename algorithm_type::plan_cache_type plan_cache_type;
+        typedef std::chrono::high_resolution_clock clock_type;
+
+    private:
+        const ring_type *m_ptr_ring;
+        size_type m_n_threads;
+        size_type m_limit_results;
+        size_type m_timeout_seconds;
+        size_type m_join_threads;
+        std::ostream *m_out = nullptr;
+        bool m_count_only = false;
+        bool m_adaptive = false;
+        plan_cache_type *m_plan_cache = nullptr;
+        mutable std::mutex m_out_mutex;
+
+        //Size of the buffer of results of a query that is written to m_out at once
+        static const size_type out_buffer_size = 1 << 16;
+
+        void write(std::string &buffer) const {
+            std::lock_guard<std::mutex> lock(m_out_mutex);
+            m_out->write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+
+    public:
+        /**
+         * @param ring              Ring
+         * @param n_threads         Number of threads running queries
+         * @param limit_results     Limit of results of each query (0 for no limit)
+         * @param timeout_seconds   Timeout of each query in seconds (0 for no timeout)
+         * @param join_threads      Number of threads running each query (see ltj_algorithm::join_parallel)
+         * @throws std::invalid_argument if several threads are used on a ring without concurrent selects
+         */
+        query_executor(const ring_type *ring, const size_type n_threads = 1,
+                       const size_type limit_results = 1000, const size_type timeout_seconds = 600,
+                       const size_type join_threads = 1)
+                : m_ptr_ring(ring), m_n_threads(n_threads), m_limit_results(limit_results),
+                  m_timeout_seconds(timeout_seconds), m_join_threads(join_threads) {
+            if ((n_threads > 1 || join_threads > 1) && !ring->concurrent_select()) {
+                throw std::invalid_argument("Several threads need a ring with set_concurrent_select(true)");
+            }
+        }
+
+        /**
+         * Writes the results of the queries to a stream, one per line: the number of the query followed by
+         * the bindings "?var=value". The results are not kept in memory, and the lines of different queries
+         * may be interleaved.
+         *
+         * @param out   Output stream, or nullptr to only count the results
+         */
+        void set_output(std::ostream *out) {
+            m_out = out;
+        }
+
+        /**
+         * Only counts the results of the queries, with ltj_algorithm::join_count. The results are not
+         * written and each query runs on one thread.
+         *
+         * @param count_only    True to count the results
+         */
+        void set_count_only(const bool count_only) {
+            m_count_only = count_only;
+        }
+
+        /**
+         * Chooses the order of the variables at each node of the search (see ltj_algorithm::set_adaptive).
+         *
+         * @param adaptive  True for the adaptive order
+         */
+        void set_adaptive(const bool adaptive) {
+            m_adaptive = adaptive;
+        }
+
+        /**
+         * Reuses the GAO and the levels of the previous queries with the same shape (see plan_cache).
+         *
+         * @param cache     Plan cache, or nullptr to plan every query
+         */
+        void set_plan_cache(plan_cache_type *cache) {
+            m_plan_cache = cache;
+        }
+
+        /**
+         * Parses and runs a query in the calling thread.
+         *
+         * @param query_string  Query
+         * @param id            Number of the query in the output
+         */
+        query_stats_type run_query(const std::string &query_string, const size_type id = 0) const {
+            std::unordered_map<std::string, uint8_t> hash_table_vars;
+            std::vector<triple_pattern> query;
+            query_parser::get_query(query_string, query, hash_table_vars);
+            std::vector<std::string> var_names(hash_table_vars.size());
+            for (const auto &v : hash_table_vars) var_names[v.second] = v.first;
+
+            auto start = clock_type::now();
+            std::string buffer;
+            auto sink = [this, id, &var_names, &buffer](const typename algorithm_type::tuple_type &t) {
+                if (m_out == nullptr) return true;
+                buffer += std::to_string(id);
+                for (uint64_t i = 0; i < t.size(); ++i) {
+                    buffer += (i == 0) ? ";?" : " ?";
+                    buffer += var_names[t[i].first];
+                    buffer += '=';
+                    buffer += std::to_string(t[i].second);
+                }
+                buffer += '\n';
+                if (buffer.size() >= out_buffer_size) write(buffer);
+                return true;
+            };
+            algorithm_type ltj(&query, m_ptr_ring, m_plan_cache);
+            ltj.set_adaptive(m_adaptive);
+            query_stats_type stats;
+            if (m_count_only) {
+                stats.n_results = ltj.join_count(m_limit_results, m_timeout_seconds);
+            } else if (m_join_threads > 1) {
+                stats.n_results = ltj.join_parallel_stream(sink, m_join_threads, m_limit_results, m_timeout_seconds);
+            } else {
+                stats.n_results = ltj.join_stream(sink, m_limit_results, m_timeout_seconds);
+            }
+            if (!buffer.empty()) write(buffer);
+            auto stop = clock_type::now();
+            stats.n_leaps = ltj.n_leaps();
+
+            stats.time_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+            return stats;
+        }
+
+        /**
+         * Runs the queries. Each thread takes the next query that has not been started.
+         *
+         * @param queries   Queries, one per line of the query file
+         * @param stats     Results of each query, in the order of queries
+         * @return          Elapsed time in nanoseconds
+         */
+        uint64_t run(const std::vector<std::string> &queries, std::vector<query_stats_type> &stats) const {
+            stats.resize(queries.size());
+            std::vector<parallel::task_type> tasks;
+            tasks.reserve(queries.size());
+            for (size_type i = 0; i < queries.size(); ++i) {
+                tasks.emplace_back([this, &queries, &stats, i]() {
+                    stats[i] = run_query(queries[i], i);
+                });
+            }
+            auto start = clock_type::now();
+            parallel::run_tasks(tasks, m_n_threads);
+            auto stop = clock_type::now();
+            return std::chrono::duration_cast<std::chrono::nanoseconds>(stop - start).count();
+        }
+    };
+}
+
+#endif //RING_QUERY_EXECUTOR_HPP
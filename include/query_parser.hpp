@@ -0,0 +1,184 @@
+/*
+ * query_parser.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_QUERY_PARSER_HPP
+#define RING_QUERY_PARSER_HPP
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <triple_pattern.hpp>
+
+namespace ring {
+
+    /*
+     * Queries are given one per line, as triple patterns separated by '.'. Each triple pattern has three
+     * terms separated by spaces: a variable (?name) or a constant.
+     */
+    namespace query_parser {
+
+        inline bool get_file_content(const std::string &filename, std::vector<std::string> &vector_of_strings) {
+            std::ifstream in(filename.c_str());
+            if (!in) {
+                std::cerr << "Cannot open the File : " << filename << std::endl;
+                return false;
+            }
+            std::string str;
+            while (getline(in, str)) {
+                if (str.size() > 0)
+                    vector_of_strings.push_back(str);
+            }
+            return true;
+        }
+
+        inline std::string ltrim(const std::string &s) {
+            size_t start = s.find_first_not_of(' ');
+            return (start == std::string::npos) ? "" : s.substr(start);
+        }
+
+        inline std::string rtrim(const std::string &s) {
+            size_t end = s.find_last_not_of(' ');
+            return (end == std::string::npos) ? "" : s.substr(0, end + 1);
+        }
+
+        inline std::string trim(const std::string &s) {
+            return rtrim(ltrim(s));
+        }
+
+        inline std::vector<std::string> tokenizer(const std::string &input, const char &delimiter) {
+            std::stringstream stream(input);
+            std::string token;
+            std::vector<std::string> res;
+            while (getline(stream, token, delimiter)) {
+                res.emplace_back(trim(token));
+            }
+            return res;
+        }
+
+        inline bool is_variable(const std::string &s) {
+            return (s.at(0) == '?');
+        }
+
+        inline uint8_t get_variable(const std::string &s, std::unordered_map<std::string, uint8_t> &hash_table_vars) {
+            auto var = s.substr(1);
+            auto it = hash_table_vars.find(var);
+            if (it == hash_table_vars.end()) {
+                uint8_t id = hash_table_vars.size();
+                hash_table_vars.insert({var, id});
+                return id;
+            } else {
+                return it->second;
+            }
+        }
+
+        //Placeholder of a prepared query, given as $name
+        inline bool is_parameter(const std::string &s) {
+            return (s.at(0) == '$');
+        }
+
+        inline uint64_t get_constant(const std::string &s) {
+            return std::stoull(s);
+        }
+
+        inline triple_pattern get_triple(const std::string &s, std::unordered_map<std::string, uint8_t> &hash_table_vars) {
+            std::vector<std::string> terms = tokenizer(s, ' ');
+
+            triple_pattern triple;
+            if (is_variable(terms[0])) {
+                triple.var_s(get_variable(terms[0], hash_table_vars));
+            } else {
+                triple.const_s(get_constant(terms[0]));
+            }
+            if (is_variable(terms[1])) {
+                triple.var_p(get_variable(terms[1], hash_table_vars));
+            } else {
+                triple.const_p(get_constant(terms[1]));
+            }
+            if (is_variable(terms[2])) {
+                triple.var_o(get_variable(terms[2], hash_table_vars));
+            } else {
+                triple.const_o(get_constant(terms[2]));
+            }
+            return triple;
+        }
+
+        //Term of a prepared query that takes the value of a parameter
+        typedef struct {
+            uint64_t pattern; //index of the triple pattern
+            uint8_t term;     //0 for the subject, 1 for the predicate, 2 for the object
+            uint64_t param;   //index of the parameter
+        } parameter_slot;
+
+        /**
+         * Parses a query whose constants may be parameters ($name). The terms of the parameters are
+         * constants with value 0 until they are bound.
+         *
+         * @param query_string      Query
+         * @param query             Vector where the triple patterns are appended
+         * @param hash_table_vars   Identifiers given to the names of the variables
+         * @param hash_table_params Identifiers given to the names of the parameters, by first occurrence
+         * @param slots             Terms of the parameters
+         */
+        inline void get_prepared_query(const std::string &query_string, std::vector<triple_pattern> &query,
+                                       std::unordered_map<std::string, uint8_t> &hash_table_vars,
+                                       std::unordered_map<std::string, uint64_t> &hash_table_params,
+                                       std::vector<parameter_slot> &slots) {
+            std::vector<std::string> tokens_query = tokenizer(query_string, '.');
+            for (const std::string &token : tokens_query) {
+                std::vector<std::string> terms = tokenizer(token, ' ');
+                std::string pattern;
+                for (uint8_t t = 0; t < 3; ++t) {
+                    if (is_parameter(terms[t])) {
+                        auto it = hash_table_params.find(terms[t]);
+                        uint64_t id = hash_table_params.size();
+                        if (it == hash_table_params.end()) {
+                            hash_table_params.insert({terms[t], id});
+                        } else {
+                            id = it->second;
+                        }
+                        slots.push_back({query.size(), t, id});
+                        terms[t] = "0";
+                    }
+                    pattern += (t == 0 ? "" : " ") + terms[t];
+                }
+                query.push_back(get_triple(pattern, hash_table_vars));
+            }
+        }
+
+        /**
+         * Parses a query.
+         *
+         * @param query_string      Line of the query file
+         * @param query             Vector where the triple patterns are appended
+         * @param hash_table_vars   Identifiers given to the names of the variables
+         */
+        inline void get_query(const std::string &query_string, std::vector<triple_pattern> &query,
+                              std::unordered_map<std::string, uint8_t> &hash_table_vars) {
+            std::vector<std::string> tokens_query = tokenizer(query_string, '.');
+            for (const std::string &token : tokens_query) {
+                query.push_back(get_triple(token, hash_table_vars));
+            }
+        }
+    }
+}
+
+#endif //RING_QUERY_PARSER_HPP
@@ -23,6 +23,9 @@
 #include <cstdint>
 #include "bwt.hpp"
 #include "bwt_interval.hpp"
+#include "parallel.hpp"
+#include "stats_catalog.hpp"
+#include "external_sort.hpp"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -47,6 +50,7 @@ namespace ring {
         size_type m_max_p;
         size_type m_max_o;
         size_type m_n_triples;  // number of triples
+        stats_catalog m_stats;
 
         void copy(const ring &o) {
             m_bwt_s = o.m_bwt_s;
@@ -56,15 +60,193 @@ namespace ring {
             m_max_p = o.m_max_p;
             m_max_o = o.m_max_o;
             m_n_triples = o.m_n_triples;
+            m_stats = o.m_stats;
+        }
+
+        //Lexicographic orders of the triples
+        struct osp_order {
+            inline bool operator()(const spo_triple_type &a, const spo_triple_type &b) const {
+                return std::tie(std::get<2>(a), std::get<0>(a), std::get<1>(a))
+                       < std::tie(std::get<2>(b), std::get<0>(b), std::get<1>(b));
+            }
+        };
+
+        struct pos_order {
+            inline bool operator()(const spo_triple_type &a, const spo_triple_type &b) const {
+                return std::tie(std::get<1>(a), std::get<2>(a), std::get<0>(a))
+                       < std::tie(std::get<1>(b), std::get<2>(b), std::get<0>(b));
+            }
+        };
+
+        //Computes the statistics of stats_catalog. The distinct subjects and objects of each predicate are
+        //counted while the triples are sorted, and the totals are taken from the C arrays
+        void build_stats(sdsl::int_vector<> &distinct_s, sdsl::int_vector<> &distinct_o) {
+            uint64_t n_subjects = 0, n_objects = 0;
+            for (uint64_t v = 1; v <= m_max_s; ++v) {
+                if (m_bwt_o.nElems(v) > 0) ++n_subjects;
+            }
+            for (uint64_t v = 1; v <= m_max_o; ++v) {
+                if (m_bwt_p.nElems(v) > 0) ++n_objects;
+            }
+            m_stats = stats_catalog(distinct_s, distinct_o, n_subjects, n_objects);
+        }
+
+        //Number of occurrences of each symbol (up to max_symbol) in the t_pos-th component of the triples
+        template<uint8_t t_pos>
+        static std::vector<uint32_t> count_symbols(const vector<spo_triple_type> &D, const uint64_t max_symbol) {
+            std::vector<uint32_t> M(max_symbol + 1, 0);
+            for (const auto &t : D)
+                M[std::get<t_pos>(t)]++;
+            return M;
+        }
+
+        //C array of a BWT given the number of occurrences M of each symbol in 1..sigma
+        static vector<uint64_t> build_C(const std::vector<uint32_t> &M, const uint64_t sigma, const uint64_t n) {
+            vector<uint64_t> C;
+            C.reserve(sigma + 2);
+            uint64_t cur_pos = 1;
+            C.push_back(0); // Dummy value
+            C.push_back(cur_pos);
+            for (uint64_t c = 2; c <= sigma; c++) {
+                cur_pos += M[c-1];
+                C.push_back(cur_pos);
+            }
+            C.push_back(n+1);
+            return C;
+        }
+
+        /**
+         * In-place counting sort of D by the t_pos-th component of the triples. The C array gives the
+         * first position (1-based) of each symbol.
+         *
+         * @param D         Triples
+         * @param C         C array of the t_pos-th component
+         * @param sigma     Maximum value of the t_pos-th component
+         */
+        template<uint8_t t_pos>
+        static void bucket_sort(vector<spo_triple_type> &D, const vector<uint64_t> &C, const uint64_t sigma) {
+            vector<uint64_t> next(C.begin(), C.begin() + sigma + 1);
+            for (uint64_t c = 1; c <= sigma; ++c) {
+                uint64_t end = C[c+1];
+                while (next[c] < end) {
+                    spo_triple_type t = D[next[c]-1];
+                    uint64_t d = std::get<t_pos>(t);
+                    while (d != c) {
+                        std::swap(t, D[next[d]-1]);
+                        ++next[d];
+                        d = std::get<t_pos>(t);
+                    }
+                    D[next[c]-1] = t;
+                    ++next[c];
+                }
+            }
+        }
+
+        /**
+         * Sorts the triples within each bucket of D with cmp. The buckets are split among n_threads threads.
+         *
+         * @param D         Triples sorted by their first component in the order of cmp
+         * @param C         C array of that component
+         * @param sigma     Maximum value of that component
+         * @param cmp       Order of the triples
+         * @param n_threads Maximum number of threads
+         */
+        template<class t_cmp>
+        static void sort_buckets(vector<spo_triple_type> &D, const vector<uint64_t> &C, const uint64_t sigma,
+                                 const t_cmp &cmp, const uint64_t n_threads) {
+            uint64_t n_tasks = (n_threads > 1) ? 4 * n_threads : 1;
+            uint64_t task_size = D.size() / n_tasks + 1;
+            std::vector<parallel::task_type> tasks;
+            uint64_t c = 1;
+            while (c <= sigma) {
+                uint64_t first = c;
+                while (c <= sigma && C[c+1] - C[first] < task_size) ++c;
+                if (c == first) ++c; // a bucket larger than task_size
+                uint64_t last = c; // buckets [first, last)
+                tasks.emplace_back([&D, &C, &cmp, first, last]() {
+                    for (uint64_t b = first; b < last; ++b) {
+                        if (C[b+1] - C[b] > 1) std::sort(D.begin() + (C[b] - 1), D.begin() + (C[b+1] - 1), cmp);
+                    }
+                });
+            }
+            parallel::run_tasks(tasks, n_threads);
+        }
+
+        /**
+         * Bytes that the construction of the wavelet matrix of a column of n values of width bits takes
+         * (estimated): the wavelet matrix copies the column, permutes it level by level in a second vector,
+         * and stores one bit per value and level with its rank and select structures.
+         */
+        static uint64_t wm_build_bytes(const uint64_t n, const uint64_t width) {
+            uint64_t column = ((n + 1) * width + 63) / 64 * 8;
+            return 2 * column + column + column / 2;
+        }
+
+        /**
+         * BWT built from disk: the triples of the dataset are sorted with external::make_runs and the runs are
+         * merged while the last column is written to disk. The wavelet matrix is built in memory from that
+         * file, so it must fit in the budget together with the BWTs already built (used); otherwise it throws
+         * before the triples are sorted.
+         *
+         * @tparam t_key    Component of the triples that gives the C array (first in the order)
+         * @tparam t_pos    Component of the triples in the last column
+         * @param n         Number of triples of the dataset; set to the number of distinct triples
+         * @param max_key   Maximum value of the t_key-th component
+         * @param max_pos   Maximum value of the t_pos-th component
+         * @param used      Bytes of memory already in use, which are not available for this BWT
+         * @param visit     Called as visit(triple) for each triple, in the order of cmp
+         */
+        template<uint8_t t_key, uint8_t t_pos, class t_bwt, class t_cmp, class t_visit>
+        static t_bwt build_bwt_external(const std::string &dataset, const external::config &cfg,
+                                        const std::string &name, t_cmp cmp, uint64_t &n,
+                                        const uint64_t max_key, const uint64_t max_pos, const uint64_t used,
+                                        t_visit &&visit) {
+            uint64_t counts = (max_key + 1) * sizeof(uint32_t) + (max_key + 2) * sizeof(uint64_t);
+            uint64_t wm_bytes = wm_build_bytes(n, bits::hi(max_pos) + 1);
+            if (used + counts + wm_bytes > cfg.memory_budget) {
+                throw std::runtime_error("The wavelet matrix of " + name + " needs about "
+                                         + util::to_string(used + counts + wm_bytes) + " bytes of memory,"
+                                         + " more than the budget of " + util::to_string(cfg.memory_budget));
+            }
+            //The runs and the buffers of the merge take the memory that is left
+            external::config run_cfg = cfg;
+            run_cfg.memory_budget = cfg.memory_budget - used - counts;
+
+            auto runs = external::make_runs(dataset, run_cfg, name, cmp);
+            std::vector<uint32_t> M(max_key + 1, 0);
+            std::string L_file = external::tmp_file_name(cfg, name + "_L");
+            {
+                int_vector_buffer<> L(L_file, std::ios::out, 1024*1024, bits::hi(max_pos) + 1);
+                L.push_back(0);
+                external::merge_runs(runs, run_cfg, cmp, [&L, &M, &visit](const spo_triple_type &t) {
+                    L.push_back(std::get<t_pos>(t));
+                    M[std::get<t_key>(t)]++;
+                    visit(t);
+                });
+            }
+            n = 0;
+            for (uint64_t c = 1; c <= max_key; ++c) n += M[c];
+            vector<uint64_t> C = build_C(M, max_key, n);
+            std::vector<uint32_t>().swap(M);
+            t_bwt b;
+            {
+                int_vector_buffer<> L(L_file);
+                b = t_bwt(L, C);
+            }
+            sdsl::remove(L_file);
+            return b;
         }
 
     public:
         ring() = default;
 
-        // Assumes the triples have been stored in a vector<spo_triple>
-        ring(vector<spo_triple_type> &D) {
-            uint64_t i, pos_c;
-            vector<spo_triple>::iterator it, triple_begin = D.begin(), triple_end = D.end();
+        // Assumes the triples have been stored in a vector<spo_triple>, which must not be empty. D is released
+        // during the construction. Repeated triples are stored once, and m_n_triples counts the distinct ones.
+        // D is sorted in place as SPO, OSP and POS with counting sorts whose bucket starts are the C arrays of
+        // the BWTs, and the last column of each order is taken before the next sort, so at most one last column
+        // is alive with D. With n_threads > 1 the buckets are sorted concurrently, and the BWT of each order is
+        // built while D is sorted in the next one.
+        ring(vector<spo_triple_type> &D, const uint64_t n_threads = 1) {
             uint64_t U, n = m_n_triples = D.size();
 
             {
@@ -87,114 +269,123 @@ namespace ring {
             uint64_t alphabet_SO = U;
             m_max_s = m_max_o = alphabet_SO;
 
-            std::vector<uint32_t> M_O, M_S, M_P;
-
-            for (i = 1; i <= alphabet_SO; i++)
-                M_S.push_back(0);
-            M_S.shrink_to_fit();
-
-            for (it = triple_begin, i=0; i<n; i++, it++)
-                M_S[std::get<0>(*it)]++;
-
-            // Sorts the triples lexycographically
-            sort(triple_begin, triple_end);
+            vector<uint64_t> new_C_O = build_C(count_symbols<0>(D, alphabet_SO), alphabet_SO, n);
+            uint64_t sort_threads = std::max<uint64_t>(n_threads, 2) - 1; //one thread builds the previous BWT
+
+            // Sorts the triples lexycographically: by S in place, and then each bucket of S.
+            // Repeated triples are removed, so each triple of the index is distinct
+            bucket_sort<0>(D, new_C_O, alphabet_SO);
+            sort_buckets(D, new_C_O, alphabet_SO, std::less<spo_triple_type>(), n_threads);
+            D.erase(std::unique(D.begin(), D.end()), D.end());
+            if (D.size() < n) {
+                n = m_n_triples = D.size();
+                new_C_O = build_C(count_symbols<0>(D, alphabet_SO), alphabet_SO, n);
+            }
+            vector<uint64_t> new_C_P = build_C(count_symbols<2>(D, alphabet_SO), alphabet_SO, n);
+            vector<uint64_t> new_C_S = build_C(count_symbols<1>(D, m_max_p), m_max_p, n);
+
+            // BWT(O) is the last column of SPO. The subjects of each predicate come sorted in SPO
+            distinct_counter subjects(m_max_p), objects(m_max_p);
+            int_vector<> L(n+1, 0, bits::hi(alphabet_SO) + 1);
+            for (uint64_t i = 1; i <= n; i++) {
+                L[i] = std::get<2>(D[i-1]);
+                subjects.add(std::get<1>(D[i-1]), std::get<0>(D[i-1]));
+            }
 
-            // First O
+            // Builds BWT(O) while D is sorted as OSP. BWT(P) is the last column of OSP
             {
-                uint64_t i, c;
-                vector<uint64_t> new_C_O;
-                uint64_t cur_pos = 1;
-                new_C_O.push_back(0); // Dummy value
-                new_C_O.push_back(cur_pos);
-                for (c = 2; c <= alphabet_SO; c++) {
-                    cur_pos += M_S[c-1];
-                    new_C_O.push_back(cur_pos);
-                }
-                new_C_O.push_back(n+1);
-                new_C_O.shrink_to_fit();
-
-                M_S.clear();
-                M_S.shrink_to_fit();
-
-                int_vector<> new_O(n+1);
-                new_O[0] = 0;
-                for (i=1; i<=n; i++)
-                    new_O[i] = std::get<2>(D[i-1]);
-
-                util::bit_compress(new_O);
-                // builds the WT for BWT(O)
-                m_bwt_o = bwt_so_type(new_O, new_C_O);
+                std::vector<parallel::task_type> tasks;
+                tasks.emplace_back([&]() {
+                    util::bit_compress(L);
+                    m_bwt_o = bwt_so_type(L, new_C_O);
+                    int_vector<>().swap(L);
+                });
+                tasks.emplace_back([&]() {
+                    bucket_sort<2>(D, new_C_P, alphabet_SO);
+                    sort_buckets(D, new_C_P, alphabet_SO, osp_order(), sort_threads);
+                });
+                parallel::run_tasks(tasks, n_threads);
             }
+            L = int_vector<>(n+1, 0, bits::hi(m_max_p) + 1);
+            for (uint64_t i = 1; i <= n; i++)
+                L[i] = std::get<1>(D[i-1]);
 
-            M_O.resize(alphabet_SO+1, 0);
-            M_O.shrink_to_fit();
-
-            for (it = triple_begin, i=0; i<n; i++, it++)
-                M_O[std::get<2>(*it)]++;
-
-            stable_sort(D.begin(), D.end(), [](const spo_triple& a,
-                    const spo_triple& b) {return std::get<2>(a) < std::get<2>(b);});
+            // Builds BWT(P) while D is sorted as POS. BWT(S) is the last column of POS, where the objects of
+            // each predicate come sorted
             {
-                uint64_t c, i;
-                vector<uint64_t> new_C_P;
-
-                uint64_t cur_pos = 1;
-                new_C_P.push_back(0);  // Dummy value
-                new_C_P.push_back(cur_pos);
-                for (c = 2; c <= alphabet_SO; c++) {
-                    cur_pos += M_O[c-1];
-                    new_C_P.push_back(cur_pos);
-                }
-                new_C_P.push_back(n+1);
-                new_C_P.shrink_to_fit();
-
-                M_O.clear();
-
-                int_vector<> new_P(n+1);
-                new_P[0] = 0;
-                for (i=1; i<=n; i++)
-                    new_P[i] = std::get<1>(D[i-1]);
-
-                util::bit_compress(new_P);
-                m_bwt_p = bwt_p_type(new_P, new_C_P);
+                std::vector<parallel::task_type> tasks;
+                tasks.emplace_back([&]() {
+                    util::bit_compress(L);
+                    m_bwt_p = bwt_p_type(L, new_C_P);
+                    int_vector<>().swap(L);
+                });
+                tasks.emplace_back([&]() {
+                    bucket_sort<1>(D, new_C_S, m_max_p);
+                    sort_buckets(D, new_C_S, m_max_p, pos_order(), sort_threads);
+                });
+                parallel::run_tasks(tasks, n_threads);
             }
+            L = int_vector<>(n+1, 0, bits::hi(alphabet_SO) + 1);
+            for (uint64_t i = 1; i <= n; i++) {
+                L[i] = std::get<0>(D[i-1]);
+                objects.add(std::get<1>(D[i-1]), std::get<2>(D[i-1]));
+            }
+            vector<spo_triple_type>().swap(D);
 
-            M_P.resize(m_max_p+1, 0);
-            M_P.shrink_to_fit();
+            util::bit_compress(L);
+            m_bwt_s = bwt_so_type(L, new_C_S);
+            int_vector<>().swap(L);
+            build_stats(subjects.distinct(), objects.distinct());
 
-            for (it = triple_begin, i=0; i<n; i++, it++)
-                M_P[std::get<1>(*it)]++;
+            cout << "-- Index constructed successfully" << endl; fflush(stdout);
+        };
 
-            stable_sort(D.begin(), D.end(), [](const spo_triple& a,
-                    const spo_triple& b) {return std::get<1>(a) < std::get<1>(b); });
-            // Builds BWT_S
+        // Builds the index from the triples of a file without loading them in memory. The triples are sorted
+        // in runs that are spilled to cfg.tmp_dir, and the runs are merged to write the last column of each BWT
+        // to disk. The wavelet matrices are built in memory from those files, one at a time: cfg.memory_budget
+        // bounds the runs, the merges and each wavelet matrix with the BWTs already built, and the constructor
+        // throws std::runtime_error when a wavelet matrix does not fit. The resulting index is the same as
+        // with ring(D). It also throws std::runtime_error if the dataset is not valid or has no triples.
+        ring(const std::string &dataset, const external::config &cfg) {
+            uint64_t n = 0, max_s = 0, max_o = 0;
+            m_max_p = 0;
             {
-                uint64_t i, c;
-                vector<uint64_t> new_C_S;
-
-                uint64_t cur_pos = 1;
-                new_C_S.push_back(0);  // Dummy value
-                new_C_S.push_back(cur_pos);
-                for (c = 2; c <= m_max_p; c++) {
-                    cur_pos += M_P[c-1];
-                    new_C_S.push_back(cur_pos);
+                triple_reader reader(dataset);
+                spo_triple_type t;
+                while (reader.next(t)) {
+                    if (std::get<0>(t) > max_s) max_s = std::get<0>(t);
+                    if (std::get<1>(t) > m_max_p) m_max_p = std::get<1>(t);
+                    if (std::get<2>(t) > max_o) max_o = std::get<2>(t);
+                    ++n;
                 }
-                new_C_S.push_back(n+1);
-                new_C_S.shrink_to_fit();
-
-                M_P.clear();
-
-                int_vector<> new_S(n+1);
-                new_S[0] = 0;
-                for (i=1; i<=n; i++)
-                    new_S[i] = std::get<0>(D[i-1]);
-                util::bit_compress(new_S);
-
-                m_bwt_s = bwt_so_type(new_S, new_C_S);
             }
+            if (n == 0) throw std::runtime_error("The dataset " + dataset + " has no triples");
+            uint64_t alphabet_SO = std::max(max_s, max_o);
+            m_max_s = m_max_o = alphabet_SO;
+
+            //The subjects of each predicate come sorted in SPO, and its objects in POS
+            distinct_counter subjects(m_max_p), objects(m_max_p);
+            auto count_subjects = [&subjects](const spo_triple_type &t) {
+                subjects.add(std::get<1>(t), std::get<0>(t));
+            };
+            auto count_objects = [&objects](const spo_triple_type &t) {
+                objects.add(std::get<1>(t), std::get<2>(t));
+            };
+            uint64_t used = 4 * (m_max_p + 1) * sizeof(uint64_t); //the two distinct_counter
+            m_bwt_o = build_bwt_external<0, 2, bwt_so_type>(dataset, cfg, "spo", std::less<spo_triple_type>(),
+                                                            n, alphabet_SO, max_o, used, count_subjects);
+            used += sdsl::size_in_bytes(m_bwt_o);
+            m_bwt_p = build_bwt_external<2, 1, bwt_p_type>(dataset, cfg, "osp", osp_order(),
+                                                           n, alphabet_SO, m_max_p, used,
+                                                           [](const spo_triple_type &) {});
+            used += sdsl::size_in_bytes(m_bwt_p);
+            m_bwt_s = build_bwt_external<1, 0, bwt_so_type>(dataset, cfg, "pos", pos_order(),
+                                                            n, m_max_p, max_s, used, count_objects);
+            m_n_triples = n; //distinct triples, counted by the merges
+            build_stats(subjects.distinct(), objects.distinct());
 
             cout << "-- Index constructed successfully" << endl; fflush(stdout);
-        };
+        }
 
 
         //! Copy constructor
@@ -225,6 +416,7 @@ namespace ring {
                 m_max_p = o.m_max_p;
                 m_max_o = o.m_max_o;
                 m_n_triples = o.m_n_triples;
+                m_stats = std::move(o.m_stats);
             }
             return *this;
         }
@@ -238,24 +430,56 @@ namespace ring {
             std::swap(m_max_p, o.m_max_p);
             std::swap(m_max_o, o.m_max_o);
             std::swap(m_n_triples, o.m_n_triples);
-        }
-
-        //! Serializes the data structure into the given ostream
+            m_stats.swap(o.m_stats);
+        }
+
+        //Calls f(name, component) for each component of the three BWTs and each scalar (see index_format)
+        template<class t_ring, class t_f>
+        static void sections(t_ring &r, t_f &f) {
+            bwt_so_type::sections(r.m_bwt_s, "bwt_s.", f);
+            bwt_p_type::sections(r.m_bwt_p, "bwt_p.", f);
+            bwt_so_type::sections(r.m_bwt_o, "bwt_o.", f);
+            f("max_s", r.m_max_s);
+            f("max_p", r.m_max_p);
+            f("max_o", r.m_max_o);
+            f("n_triples", r.m_n_triples);
+            stats_catalog::sections(r.m_stats, "stats.", f);
+        }
+
+        //Writes the size of each BWT and its components
+        void print_stats(std::ostream &out) const {
+            out << "Triples: " << m_n_triples << std::endl;
+            m_stats.print_stats(out);
+            out << "BWT of S (POS): " << sdsl::size_in_bytes(m_bwt_s) << " bytes" << std::endl;
+            m_bwt_s.print_stats(out, "  ");
+            out << "BWT of P (OSP): " << sdsl::size_in_bytes(m_bwt_p) << " bytes" << std::endl;
+            m_bwt_p.print_stats(out, "  ");
+            out << "BWT of O (SPO): " << sdsl::size_in_bytes(m_bwt_o) << " bytes" << std::endl;
+            m_bwt_o.print_stats(out, "  ");
+        }
+
+        //! Serializes the data structure into the given ostream, with the format of index_format
         size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
             sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
-            size_type written_bytes = 0;
-            written_bytes += m_bwt_s.serialize(out, child, "bwt_s");
-            written_bytes += m_bwt_p.serialize(out, child, "bwt_p");
-            written_bytes += m_bwt_o.serialize(out, child, "bwt_o");
-            written_bytes += sdsl::write_member(m_max_s, out, child, "max_s");
-            written_bytes += sdsl::write_member(m_max_p, out, child, "max_p");
-            written_bytes += sdsl::write_member(m_max_o, out, child, "max_o");
-            written_bytes += sdsl::write_member(m_n_triples, out, child, "n_triples");
+            index_format::section_writer writer;
+            sections(*this, writer);
+            size_type written_bytes = writer.write(out, index_format::variant<ring>::name(), child);
             sdsl::structure_tree::add_size(child, written_bytes);
             return written_bytes;
         }
 
         void load(std::istream &in) {
+            index_format::section_reader reader(in);
+            if (reader.has_table()) {
+                sections(*this, reader);
+                reader.finish();
+                //Files written before the dense C was added do not have its section
+                m_bwt_s.init_C_dense();
+                m_bwt_p.init_C_dense();
+                m_bwt_o.init_C_dense();
+                return;
+            }
+            // Files without header: the components are back to back
             m_bwt_s.load(in);
             m_bwt_p.load(in);
             m_bwt_o.load(in);
@@ -263,8 +487,31 @@ namespace ring {
             sdsl::read_member(m_max_p, in);
             sdsl::read_member(m_max_o, in);
             sdsl::read_member(m_n_triples, in);
+            m_stats = stats_catalog();
+        }
+
+
+        /**
+         * Lets several threads query the ring at the same time: the selects of its BWTs keep their path on
+         * the stack instead of in the wavelet matrices (see bwt::set_concurrent_select). It must be set
+         * before the threads start, and query_executor and ltj_algorithm::join_parallel_stream require it
+         * when they run on several threads.
+         *
+         * @param concurrent    True if several threads query the ring at the same time
+         */
+        void set_concurrent_select(const bool concurrent) {
+            m_bwt_s.set_concurrent_select(concurrent);
+            m_bwt_p.set_concurrent_select(concurrent);
+            m_bwt_o.set_concurrent_select(concurrent);
         }
 
+        inline bool concurrent_select() const {
+            return m_bwt_s.concurrent_select();
+        }
+
+        inline const stats_catalog &stats() const {
+            return m_stats;
+        }
 
         //Given a Suffix returns its range in BWT O
         pair<uint64_t, uint64_t> init_S(uint64_t S) const {
@@ -320,7 +567,7 @@ namespace ring {
         // Functions for PSO
         //
 
-        bwt_interval open_PSO() {
+        bwt_interval open_PSO() const {
             //return bwt_interval(2 * m_n_triples + 1, 3 * m_n_triples);
             return bwt_interval( 1, m_n_triples);
         }
@@ -328,17 +575,17 @@ namespace ring {
         /**********************************/
         // P->S  (simulates going down in the trie)
         // Returns an interval within m_bwt_o
-        bwt_interval down_P_S(bwt_interval &p_int, uint64_t s) {
+        bwt_interval down_P_S(bwt_interval &p_int, uint64_t s) const {
             auto I = m_bwt_s.backward_step(p_int.left(), p_int.right(), s);
             uint64_t c = m_bwt_o.get_C(s);
             return bwt_interval(I.first + c, I.second + c);
         }
 
-        uint64_t min_O_in_S(bwt_interval &I) {
+        uint64_t min_O_in_S(bwt_interval &I) const {
             return I.begin(m_bwt_o);
         }
 
-        uint64_t next_O_in_S(bwt_interval &I, uint64_t O) {
+        uint64_t next_O_in_S(bwt_interval &I, uint64_t O) const {
             if (O > m_max_o) return 0;
 
             uint64_t nextv = I.next_value(O, m_bwt_o);
@@ -348,15 +595,15 @@ namespace ring {
                 return nextv;
         }
 
-        bool there_are_O_in_S(bwt_interval &I) {
+        bool there_are_O_in_S(bwt_interval &I) const {
             return I.get_cur_value() != I.end();
         }
 
-        uint64_t min_O_in_PS(bwt_interval &I) {
+        uint64_t min_O_in_PS(bwt_interval &I) const {
             return I.begin(m_bwt_o);
         }
 
-        uint64_t next_O_in_PS(bwt_interval &I, uint64_t O) {
+        uint64_t next_O_in_PS(bwt_interval &I, uint64_t O) const {
             if (O > m_max_o) return 0;
 
             uint64_t nextv = I.next_value(O, m_bwt_o);
@@ -366,12 +613,12 @@ namespace ring {
                 return nextv;
         }
 
-        bool there_are_O_in_PS(bwt_interval &I) {
+        bool there_are_O_in_PS(bwt_interval &I) const {
             return I.get_cur_value() != I.end();
         }
 
         std::vector<uint64_t>
-        all_O_in_range(bwt_interval &I) {
+        all_O_in_range(bwt_interval &I) const {
             return m_bwt_o.values_in_range(I.left(), I.right());
         }
 
@@ -379,7 +626,7 @@ namespace ring {
         // Functions for OPS
         //
 
-        bwt_interval open_OPS() {
+        bwt_interval open_OPS() const {
             return bwt_interval(1, m_n_triples);
         }
 
@@ -387,17 +634,17 @@ namespace ring {
         /**********************************/
         // O->P  (simulates going down in the trie)
         // Returns an interval within m_bwt_s
-        bwt_interval down_O_P(bwt_interval &o_int, uint64_t p) {
+        bwt_interval down_O_P(bwt_interval &o_int, uint64_t p) const {
             auto I = m_bwt_p.backward_step(o_int.left(), o_int.right(), p);
             uint64_t c = m_bwt_s.get_C(p);
             return bwt_interval(I.first + c, I.second + c);
         }
 
-        uint64_t min_S_in_OP(bwt_interval &I) {
+        uint64_t min_S_in_OP(bwt_interval &I) const {
             return I.begin(m_bwt_s);
         }
 
-        uint64_t next_S_in_OP(bwt_interval &I, uint64_t s_value) {
+        uint64_t next_S_in_OP(bwt_interval &I, uint64_t s_value) const {
             if (s_value > m_max_s) return 0;
 
             uint64_t nextv = I.next_value(s_value, m_bwt_s);
@@ -407,15 +654,15 @@ namespace ring {
                 return nextv;
         }
 
-        bool there_are_S_in_OP(bwt_interval &I) {
+        bool there_are_S_in_OP(bwt_interval &I) const {
             return I.get_cur_value() != I.end();
         }
 
-        uint64_t min_S_in_P(bwt_interval &I) {
+        uint64_t min_S_in_P(bwt_interval &I) const {
             return I.begin(m_bwt_s);
         }
 
-        uint64_t next_S_in_P(bwt_interval &I, uint64_t s_value) {
+        uint64_t next_S_in_P(bwt_interval &I, uint64_t s_value) const {
             if (s_value > m_max_s) return 0;
 
             uint64_t nextv = I.next_value(s_value, m_bwt_s);
@@ -425,12 +672,12 @@ namespace ring {
                 return nextv;
         }
 
-        bool there_are_S_in_P(bwt_interval &I) {
+        bool there_are_S_in_P(bwt_interval &I) const {
             return I.get_cur_value() != I.end();
         }
 
         std::vector<uint64_t>
-        all_S_in_range(bwt_interval &I) {
+        all_S_in_range(bwt_interval &I) const {
             return m_bwt_s.values_in_range(I.left(), I.right());
         }
 
@@ -439,7 +686,7 @@ namespace ring {
         // Function for SOP
         //
 
-        bwt_interval open_SOP() {
+        bwt_interval open_SOP() const {
             return bwt_interval(1,  m_n_triples);
         }
 
@@ -448,17 +695,17 @@ namespace ring {
         /**********************************/
         // S->O  (simulates going down in the trie)
         // Returns an interval within m_bwt_p
-        bwt_interval down_S_O(bwt_interval &s_int, uint64_t o) {
+        bwt_interval down_S_O(bwt_interval &s_int, uint64_t o) const {
             pair<uint64_t, uint64_t> I = m_bwt_o.backward_step(s_int.left(), s_int.right(), o);
             uint64_t c = m_bwt_p.get_C(o);
             return bwt_interval(I.first + c, I.second + c);
         }
 
-        uint64_t min_P_in_SO(bwt_interval &I) {
+        uint64_t min_P_in_SO(bwt_interval &I) const {
             return I.begin(m_bwt_p);
         }
 
-        uint64_t next_P_in_SO(bwt_interval &I, uint64_t p_value) {
+        uint64_t next_P_in_SO(bwt_interval &I, uint64_t p_value) const {
             if (p_value > m_max_p) return 0;
 
             uint64_t nextv = I.next_value(p_value, m_bwt_p);
@@ -468,15 +715,15 @@ namespace ring {
                 return nextv;
         }
 
-        bool there_are_P_in_SO(bwt_interval &I) {
+        bool there_are_P_in_SO(bwt_interval &I) const {
             return I.get_cur_value() != I.end();
         }
 
-        uint64_t min_P_in_O(bwt_interval &I) {
+        uint64_t min_P_in_O(bwt_interval &I) const {
             return I.begin(m_bwt_p);
         }
 
-        uint64_t next_P_in_O(bwt_interval &I, uint64_t p_value) {
+        uint64_t next_P_in_O(bwt_interval &I, uint64_t p_value) const {
             if (p_value > m_max_p) return 0;
 
             uint64_t nextv = I.next_value(p_value, m_bwt_p);
@@ -486,12 +733,12 @@ namespace ring {
                 return nextv;
         }
 
-        bool there_are_P_in_O(bwt_interval &I) {
+        bool there_are_P_in_O(bwt_interval &I) const {
             return I.get_cur_value() != I.end();
         }
 
         std::vector<uint64_t>
-        all_P_in_range(bwt_interval &I) {
+        all_P_in_range(bwt_interval &I) const {
             return m_bwt_p.values_in_range(I.left(), I.right());
         }
 
@@ -499,21 +746,21 @@ namespace ring {
         /**********************************/
         // Functions for SPO
         //
-        bwt_interval open_SPO() {
+        bwt_interval open_SPO() const {
             return bwt_interval(1, m_n_triples);
         }
 
-        uint64_t min_S(bwt_interval &I) {
+        uint64_t min_S(bwt_interval &I) const {
             return I.begin(m_bwt_s);
         }
 
-        uint64_t next_S(bwt_interval &I, uint64_t s_value) {
+        uint64_t next_S(bwt_interval &I, uint64_t s_value) const {
             if (s_value > m_max_s) return 0;
 
             return I.next_value(s_value, m_bwt_s);
         }
 
-        bwt_interval down_S(uint64_t s_value) {
+        bwt_interval down_S(uint64_t s_value) const {
             pair<uint64_t, uint64_t> i = init_S(s_value);
             return bwt_interval(i.first, i.second);
         }
@@ -521,29 +768,33 @@ namespace ring {
 
         // S->P  (simulates going down in the trie, for the order SPO)
         // Returns an interval within m_bwt_p
-        bwt_interval down_S_P(bwt_interval &s_int, uint64_t s_value, uint64_t p_value) {
+        bwt_interval down_S_P(bwt_interval &s_int, uint64_t s_value, uint64_t p_value) const {
             std::pair<uint64_t, uint64_t> q = s_int.get_stored_values();
             uint64_t b = q.first;
             if (q.first == (uint64_t) -1) {
                 q = m_bwt_s.select_next(p_value, s_value, m_bwt_o.nElems(s_value));
                 b = m_bwt_s.bsearch_C(q.first) - 1;
             }
-            uint64_t nE = m_bwt_s.rank(b + 1, s_value) - m_bwt_s.rank(b, s_value);
+            auto R = m_bwt_s.rank_pair(m_bwt_s.get_C(b), m_bwt_s.get_C(b + 1), s_value);
+            uint64_t nE = R.second - R.first;
             uint64_t start = q.second;
 
             return bwt_interval(s_int.left() + start, s_int.left() + start + nE - 1);
         }
 
-        uint64_t min_P_in_S(bwt_interval &I, uint64_t s_value);
-
+        uint64_t min_P_in_S(bwt_interval &I, uint64_t s_value) const {
+            return min_P_in_S(I, s_value, has_select_next<bwt_so_t>());
+        }
 
-        uint64_t next_P_in_S(bwt_interval &I, uint64_t s_value, uint64_t p_value);
+        uint64_t next_P_in_S(bwt_interval &I, uint64_t s_value, uint64_t p_value) const {
+            return next_P_in_S(I, s_value, p_value, has_select_next<bwt_so_t>());
+        }
 
-        uint64_t min_O_in_SP(bwt_interval &I) {
+        uint64_t min_O_in_SP(bwt_interval &I) const {
             return I.begin(m_bwt_o);
         }
 
-        uint64_t next_O_in_SP(bwt_interval &I, uint64_t O) {
+        uint64_t next_O_in_SP(bwt_interval &I, uint64_t O) const {
             if (O > m_max_o) return 0;
 
             uint64_t next_v = I.next_value(O, m_bwt_o);
@@ -553,7 +804,7 @@ namespace ring {
                 return next_v;
         }
 
-        bool there_are_O_in_SP(bwt_interval &I) {
+        bool there_are_O_in_SP(bwt_interval &I) const {
             return I.get_cur_value() != I.end();
         }
 
@@ -561,17 +812,17 @@ namespace ring {
         // Functions for POS
         //
 
-        bwt_interval open_POS() {
+        bwt_interval open_POS() const {
             return bwt_interval( 1, m_n_triples);
         }
 
-        uint64_t min_P(bwt_interval &I) {
+        uint64_t min_P(bwt_interval &I) const {
             //bwt_interval I_aux(I.left() - 2 * m_n_triples, I.right() - 2 * m_n_triples);
             //return I_aux.begin(m_bwt_p);
             return I.begin(m_bwt_p);
         }
 
-        uint64_t next_P(bwt_interval &I, uint64_t p_value) {
+        uint64_t next_P(bwt_interval &I, uint64_t p_value) const {
             if (p_value > m_max_p) return 0;
 
             //bwt_interval I_aux(I.left() - 2 * m_n_triples, I.right() - 2 * m_n_triples);
@@ -583,27 +834,28 @@ namespace ring {
                 return nextv;
         }
 
-        bwt_interval down_P(uint64_t p_value) {
+        bwt_interval down_P(uint64_t p_value) const {
             pair<uint64_t, uint64_t> i = init_P(p_value);
             return bwt_interval(i.first, i.second);
         }
 
         // P->O  (simulates going down in the trie, for the order POS)
         // Returns an interval within m_bwt_p
-        bwt_interval down_P_O(bwt_interval &p_int, uint64_t p_value, uint64_t o_value) {
+        bwt_interval down_P_O(bwt_interval &p_int, uint64_t p_value, uint64_t o_value) const {
             std::pair<uint64_t, uint64_t> q = p_int.get_stored_values();
             uint64_t b = q.first;
             if (q.first == (uint64_t) -1) {
                 q = m_bwt_p.select_next(o_value, p_value, m_bwt_s.nElems(p_value));
                 b = m_bwt_p.bsearch_C(q.first) - 1;
             }
-            uint64_t nE = m_bwt_p.rank(b + 1, p_value) - m_bwt_p.rank(b, p_value);
+            auto R = m_bwt_p.rank_pair(m_bwt_p.get_C(b), m_bwt_p.get_C(b + 1), p_value);
+            uint64_t nE = R.second - R.first;
             uint64_t start = q.second;
 
             return bwt_interval(p_int.left() + start, p_int.left() + start + nE - 1);
         }
 
-        uint64_t min_O_in_P(bwt_interval &p_int, uint64_t p_value) {
+        uint64_t min_O_in_P(bwt_interval &p_int, uint64_t p_value) const {
             std::pair<uint64_t, uint64_t> q;
             q = m_bwt_p.select_next(1, p_value, m_bwt_s.nElems(p_value));
             uint64_t b = m_bwt_p.bsearch_C(q.first) - 1;
@@ -611,7 +863,7 @@ namespace ring {
             return b;
         }
 
-        uint64_t next_O_in_P(bwt_interval &I, uint64_t p_value, uint64_t o_value) {
+        uint64_t next_O_in_P(bwt_interval &I, uint64_t p_value, uint64_t o_value) const {
             if (o_value > m_max_o) return 0;
 
             std::pair<uint64_t, uint64_t> q;
@@ -624,13 +876,13 @@ namespace ring {
             return b;
         }
 
-        uint64_t min_S_in_PO(bwt_interval &I) {
+        uint64_t min_S_in_PO(bwt_interval &I) const {
            // bwt_interval I_aux = bwt_interval(I.left() - m_n_triples, I.right() - m_n_triples);
             //return I_aux.begin(m_bwt_s);
             return I.begin(m_bwt_s);
         }
 
-        uint64_t next_S_in_PO(bwt_interval &I, uint64_t s_value) {
+        uint64_t next_S_in_PO(bwt_interval &I, uint64_t s_value) const {
             if (s_value > m_max_s) return 0;
 
             //bwt_interval I_aux = bwt_interval(I.left() - m_n_triples, I.right() - m_n_triples);
@@ -638,7 +890,7 @@ namespace ring {
             return I.next_value(s_value, m_bwt_s);
         }
 
-        bool there_are_S_in_PO(bwt_interval &I) {
+        bool there_are_S_in_PO(bwt_interval &I) const {
             return I.get_cur_value() != I.end();
         }
 
@@ -646,15 +898,15 @@ namespace ring {
         // Functions for OSP
         //
 
-        bwt_interval open_OSP() {
+        bwt_interval open_OSP() const {
             return bwt_interval(1, m_n_triples);
         }
 
-        uint64_t min_O(bwt_interval &I) {
+        uint64_t min_O(bwt_interval &I) const {
             return I.begin(m_bwt_o);
         }
 
-        uint64_t next_O(bwt_interval &I, uint64_t o_value) {
+        uint64_t next_O(bwt_interval &I, uint64_t o_value) const {
             if (o_value > m_max_o) return 0;
 
             uint64_t nextv = I.next_value(o_value, m_bwt_o);
@@ -662,35 +914,40 @@ namespace ring {
             else return nextv;
         }
 
-        bwt_interval down_O(uint64_t o_value) {
+        bwt_interval down_O(uint64_t o_value) const {
             pair<uint64_t, uint64_t> i = init_O(o_value);
             return bwt_interval(i.first, i.second);
         }
 
         // P->O  (simulates going down in the trie, for the order OSP)
         // Returns an interval within m_bwt_p
-        bwt_interval down_O_S(bwt_interval &o_int, uint64_t o_value, uint64_t s_value) {
+        bwt_interval down_O_S(bwt_interval &o_int, uint64_t o_value, uint64_t s_value) const {
             std::pair<uint64_t, uint64_t> q = o_int.get_stored_values();
             uint64_t b = q.first;
             if (q.first == (uint64_t) -1) {
                 q = m_bwt_o.select_next(s_value, o_value, m_bwt_p.nElems(o_value));
                 b = m_bwt_o.bsearch_C(q.first) - 1;
             }
-            uint64_t nE = m_bwt_o.rank(b + 1, o_value) - m_bwt_o.rank(b, o_value);
+            auto R = m_bwt_o.rank_pair(m_bwt_o.get_C(b), m_bwt_o.get_C(b + 1), o_value);
+            uint64_t nE = R.second - R.first;
             uint64_t start = q.second;
 
             return bwt_interval(o_int.left() + start, o_int.left() + start + nE - 1);
         }
 
-        uint64_t min_S_in_O(bwt_interval &o_int, uint64_t o_value);
+        uint64_t min_S_in_O(bwt_interval &o_int, uint64_t o_value) const {
+            return min_S_in_O(o_int, o_value, has_select_next<bwt_so_t>());
+        }
 
-        uint64_t next_S_in_O(bwt_interval &I, uint64_t o_value, uint64_t s_value);
+        uint64_t next_S_in_O(bwt_interval &I, uint64_t o_value, uint64_t s_value) const {
+            return next_S_in_O(I, o_value, s_value, has_select_next<bwt_so_t>());
+        }
 
-        uint64_t min_P_in_OS(bwt_interval &I) {
+        uint64_t min_P_in_OS(bwt_interval &I) const {
             return I.begin(m_bwt_p);
         }
 
-        uint64_t next_P_in_OS(bwt_interval &I, uint64_t p_value) {
+        uint64_t next_P_in_OS(bwt_interval &I, uint64_t p_value) const {
             if (p_value > m_max_p) return 0;
 
             uint64_t nextv = I.next_value(p_value, m_bwt_p);
@@ -700,15 +957,26 @@ namespace ring {
                 return nextv;
         }
 
-        bool there_are_P_in_OS(bwt_interval &I) {
+        bool there_are_P_in_OS(bwt_interval &I) const {
             return I.get_cur_value() != I.end();
         }
 
+    private:
+        //Versions with select_next on the BWTs of S and O, or with inverse_select on the next BWT (see has_select_next)
+        uint64_t min_P_in_S(bwt_interval &I, uint64_t s_value, std::true_type) const;
+        uint64_t min_P_in_S(bwt_interval &I, uint64_t s_value, std::false_type) const;
+        uint64_t next_P_in_S(bwt_interval &I, uint64_t s_value, uint64_t p_value, std::true_type) const;
+        uint64_t next_P_in_S(bwt_interval &I, uint64_t s_value, uint64_t p_value, std::false_type) const;
+        uint64_t min_S_in_O(bwt_interval &o_int, uint64_t o_value, std::true_type) const;
+        uint64_t min_S_in_O(bwt_interval &o_int, uint64_t o_value, std::false_type) const;
+        uint64_t next_S_in_O(bwt_interval &I, uint64_t o_value, uint64_t s_value, std::true_type) const;
+        uint64_t next_S_in_O(bwt_interval &I, uint64_t o_value, uint64_t s_value, std::false_type) const;
+
     };
 
 
     template <class bwt_so_t, class bwt_sp_t> //Select in BWT
-    uint64_t ring<bwt_so_t, bwt_sp_t>::min_P_in_S(bwt_interval &I, uint64_t s_value) {
+    uint64_t ring<bwt_so_t, bwt_sp_t>::min_P_in_S(bwt_interval &I, uint64_t s_value, std::true_type) const {
         std::pair<uint64_t, uint64_t> q;
         q = m_bwt_s.select_next(1, s_value, m_bwt_o.nElems(s_value));
         uint64_t b = m_bwt_s.bsearch_C(q.first) - 1;
@@ -716,18 +984,8 @@ namespace ring {
         return b;
     }
 
-    template<> //No select in BWT
-    uint64_t ring<bwt<>>::min_P_in_S(bwt_interval &I, uint64_t s_value) {
-        uint64_t s_aux = I.left();
-        std::pair<uint64_t, uint64_t> o_r = m_bwt_o.inverse_select(s_aux);
-        uint64_t p = m_bwt_p[m_bwt_p.get_C(o_r.second) + o_r.first];
-        I.set_stored_values(p, 0);
-        return p;
-    }
-
-
-    template<> //No select in BWT
-    uint64_t ring<bwt_rrr>::min_P_in_S(bwt_interval &I, uint64_t s_value) {
+    template <class bwt_so_t, class bwt_sp_t> //No select in BWT
+    uint64_t ring<bwt_so_t, bwt_sp_t>::min_P_in_S(bwt_interval &I, uint64_t s_value, std::false_type) const {
         uint64_t s_aux = I.left();
         std::pair<uint64_t, uint64_t> o_r = m_bwt_o.inverse_select(s_aux);
         uint64_t p = m_bwt_p[m_bwt_p.get_C(o_r.second) + o_r.first];
@@ -736,7 +994,8 @@ namespace ring {
     }
 
     template <class bwt_so_t, class bwt_sp_t> //Select in BWT
-    uint64_t ring<bwt_so_t, bwt_sp_t>::next_P_in_S(bwt_interval &I, uint64_t s_value, uint64_t p_value) {
+    uint64_t ring<bwt_so_t, bwt_sp_t>::next_P_in_S(bwt_interval &I, uint64_t s_value, uint64_t p_value,
+                                                   std::true_type) const {
         if (p_value > m_max_p) return 0;
 
         std::pair<uint64_t, uint64_t> q;
@@ -750,23 +1009,9 @@ namespace ring {
         return b;
     }
 
-    template <> //NO Select in BWT
-    uint64_t ring<bwt<>>::next_P_in_S(bwt_interval &I, uint64_t s_value, uint64_t p_value) {
-        if (p_value > m_max_p) return 0;
-
-        uint64_t nValues = I.right()-I.left() + 1;
-        uint64_t r_aux = m_bwt_s.rank(p_value, s_value);
-        if (r_aux >= nValues)
-            return 0;
-        uint64_t p_aux = I.left();
-        std::pair<uint64_t, uint64_t> o_r = m_bwt_o.inverse_select(p_aux+r_aux);
-        uint64_t p = m_bwt_p[m_bwt_p.get_C(o_r.second)+o_r.first];
-        I.set_stored_values(p, r_aux);
-        return p;
-    }
-
-    template <> //NO Select in BWT
-    uint64_t ring<bwt_rrr>::next_P_in_S(bwt_interval &I, uint64_t s_value, uint64_t p_value) {
+    template <class bwt_so_t, class bwt_sp_t> //No select in BWT
+    uint64_t ring<bwt_so_t, bwt_sp_t>::next_P_in_S(bwt_interval &I, uint64_t s_value, uint64_t p_value,
+                                                   std::false_type) const {
         if (p_value > m_max_p) return 0;
 
         uint64_t nValues = I.right()-I.left() + 1;
@@ -781,7 +1026,7 @@ namespace ring {
     }
 
     template <class bwt_so_t, class bwt_sp_t> //Select in BWT
-    uint64_t ring<bwt_so_t, bwt_sp_t>::min_S_in_O(bwt_interval &o_int, uint64_t o_value) {
+    uint64_t ring<bwt_so_t, bwt_sp_t>::min_S_in_O(bwt_interval &o_int, uint64_t o_value, std::true_type) const {
         std::pair<uint64_t, uint64_t> q;
         q = m_bwt_o.select_next(1, o_value, m_bwt_p.nElems(o_value));
         uint64_t b = m_bwt_o.bsearch_C(q.first) - 1;
@@ -789,17 +1034,8 @@ namespace ring {
         return b;
     }
 
-    template <> //NO Select in BWT
-    uint64_t ring<bwt<>>::min_S_in_O(bwt_interval &o_int, uint64_t o_value) {
-        uint64_t o_aux = o_int.left();
-        std::pair<uint64_t, uint64_t> p_r = m_bwt_p.inverse_select(o_aux);
-        uint64_t s = m_bwt_s[m_bwt_s.get_C(p_r.second/*s_value*/) + p_r.first/*r*/];
-        o_int.set_stored_values(s, 0);
-        return s;
-    }
-
-    template <> //NO Select in BWT
-    uint64_t ring<bwt_rrr>::min_S_in_O(bwt_interval &o_int, uint64_t o_value) {
+    template <class bwt_so_t, class bwt_sp_t> //No select in BWT
+    uint64_t ring<bwt_so_t, bwt_sp_t>::min_S_in_O(bwt_interval &o_int, uint64_t o_value, std::false_type) const {
         uint64_t o_aux = o_int.left();
         std::pair<uint64_t, uint64_t> p_r = m_bwt_p.inverse_select(o_aux);
         uint64_t s = m_bwt_s[m_bwt_s.get_C(p_r.second/*s_value*/) + p_r.first/*r*/];
@@ -808,7 +1044,8 @@ namespace ring {
     }
 
     template <class bwt_so_t, class bwt_sp_t> //Select in BWT
-    uint64_t ring<bwt_so_t, bwt_sp_t>::next_S_in_O(bwt_interval &I, uint64_t o_value, uint64_t s_value) {
+    uint64_t ring<bwt_so_t, bwt_sp_t>::next_S_in_O(bwt_interval &I, uint64_t o_value, uint64_t s_value,
+                                                   std::true_type) const {
         if (s_value > m_max_s) return 0;
 
         std::pair<uint64_t, uint64_t> q;
@@ -821,8 +1058,9 @@ namespace ring {
         return b;
     }
 
-    template <> //NO Select in BWT
-    uint64_t ring<bwt<>>::next_S_in_O(bwt_interval &I, uint64_t o_value, uint64_t s_value) {
+    template <class bwt_so_t, class bwt_sp_t> //No select in BWT
+    uint64_t ring<bwt_so_t, bwt_sp_t>::next_S_in_O(bwt_interval &I, uint64_t o_value, uint64_t s_value,
+                                                   std::false_type) const {
         if (s_value > m_max_s) return 0;
 
         uint64_t nValues = I.right()-I.left() + 1;
@@ -836,26 +1074,72 @@ namespace ring {
         return s;
     }
 
+    typedef ring<bwt_rrr, bwt_rrr> c_ring;
+    typedef ring<bwt_plain, bwt_plain> ring_sel; //with select
+    typedef ring<bwt_cl, bwt_cl> ring_cl; //rank and select on cache-line blocks
+    typedef ring<bwt_sampled, bwt_plain> ring_sampled; //with sampled select in the BWTs of S and O
+    typedef ring<bwt<>, bwt_alphabetic> ring_alpha; //BWT of P shaped by the frequencies of the predicates
+    typedef ring<bwt_rle, bwt_rle> r_ring; //run-length encoded BWTs
+    typedef ring<bwt_adaptive, bwt_adaptive> ring_adaptive; //encoding of the bitvectors chosen per level
+
+    namespace index_format {
+
+        template<>
+        struct variant<ring<>> {
+            static std::string name() {
+                return "ring";
+            }
+        };
 
+        template<>
+        struct variant<c_ring> {
+            static std::string name() {
+                return "c-ring";
+            }
+        };
 
-    template <> //NO Select in BWT
-    uint64_t ring<bwt_rrr>::next_S_in_O(bwt_interval &I, uint64_t o_value, uint64_t s_value) {
-        if (s_value > m_max_s) return 0;
+        template<>
+        struct variant<ring_sel> {
+            static std::string name() {
+                return "ring-sel";
+            }
+        };
 
-        uint64_t nValues = I.right()-I.left() + 1;
-        uint64_t r_aux = m_bwt_o.rank(s_value, o_value);
-        if (r_aux >= nValues)
-            return 0;
-        uint64_t o_aux = I.left();
-        std::pair<uint64_t, uint64_t> p_r = m_bwt_p.inverse_select(o_aux+r_aux);
-        uint64_t s = m_bwt_s[m_bwt_s.get_C(p_r.second)+p_r.first];
-        I.set_stored_values(s, r_aux);
-        return s;
-    }
+        template<>
+        struct variant<ring_cl> {
+            static std::string name() {
+                return "ring-cl";
+            }
+        };
 
+        template<>
+        struct variant<ring_sampled> {
+            static std::string name() {
+                return "ring-sampled";
+            }
+        };
 
-    typedef ring<bwt_rrr, bwt_rrr> c_ring;
-    typedef ring<bwt_plain, bwt_plain> ring_sel; //with select
+        template<>
+        struct variant<ring_alpha> {
+            static std::string name() {
+                return "ring-alpha";
+            }
+        };
+
+        template<>
+        struct variant<r_ring> {
+            static std::string name() {
+                return "r-ring";
+            }
+        };
+
+        template<>
+        struct variant<ring_adaptive> {
+            static std::string name() {
+                return "ring-adaptive";
+            }
+        };
+    }
 
 }
 
@@ -0,0 +1,162 @@
+/*
+ * select_support_sampled.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RING_SELECT_SUPPORT_SAMPLED_HPP
+#define RING_SELECT_SUPPORT_SAMPLED_HPP
+
+#include <istream>
+#include <ostream>
+#include <string>
+#include "configuration.hpp"
+#include "cpu_kernels.hpp"
+
+namespace ring {
+
+    /*
+     * Select on a bit_vector that stores the position of one out of every sample_rate ones (t_b = 1) or
+     * zeros (t_b = 0), and scans the words from the preceding sample. It takes about 64 / sample_rate bits
+     * per bit t_b, so the rate trades space for the time of the scan: select_support_scan is the limit of
+     * no samples and select_support_mcl is close to the limit of a sample per bit.
+     *
+     * The select in the last word uses the kernel of kernels::active() for this CPU.
+     *
+     * wm_int builds its select structures from the bitvector alone, so the rate of new structures is taken
+     * from default_sample_rate(), which must be set before the index is built. The rate is serialized with
+     * the samples.
+     */
+    template<uint8_t t_b = 1>
+    class select_support_sampled {
+
+    public:
+        typedef uint64_t size_type;
+        typedef sdsl::bit_vector bit_vector_type;
+
+    private:
+        const bit_vector_type *m_v = nullptr;
+        uint64_t m_sample_rate = default_sample_rate();
+        sdsl::int_vector<> m_samples; //m_samples[j] is the position of the (j * m_sample_rate + 1)-th bit t_b
+        kernels::word_select_type m_select_word = kernels::active().select_word;
+
+        static inline uint64_t word(const uint64_t *data, const uint64_t k) {
+            return t_b ? data[k] : ~data[k];
+        }
+
+        void build() {
+            uint64_t n = m_v->size();
+            const uint64_t *data = m_v->data();
+            uint64_t count = 0;
+            for (uint64_t k = 0; k * 64 < n; ++k) {
+                uint64_t w = word(data, k);
+                if (k * 64 + 64 > n) w &= (1ULL << (n % 64)) - 1;
+                count += sdsl::bits::cnt(w);
+            }
+            uint64_t width = n ? sdsl::bits::hi(n) + 1 : 1;
+            m_samples = sdsl::int_vector<>((count + m_sample_rate - 1) / m_sample_rate, 0, width);
+            uint64_t seen = 0;
+            for (uint64_t k = 0; k * 64 < n; ++k) {
+                uint64_t w = word(data, k);
+                if (k * 64 + 64 > n) w &= (1ULL << (n % 64)) - 1;
+                uint64_t c = sdsl::bits::cnt(w);
+                //Samples in this word: the ones of rank seen + 1, ..., seen + c congruent to 1
+                uint64_t next = ((seen + m_sample_rate - 1) / m_sample_rate) * m_sample_rate + 1;
+                while (next <= seen + c) {
+                    m_samples[(next - 1) / m_sample_rate] = k * 64 + sdsl::bits::sel(w, next - seen);
+                    next += m_sample_rate;
+                }
+                seen += c;
+            }
+        }
+
+    public:
+        //Rate of the structures built from now on. It must be at least 1
+        static uint64_t &default_sample_rate() {
+            static uint64_t rate = 1024;
+            return rate;
+        }
+
+        select_support_sampled(const bit_vector_type *v = nullptr) : m_v(v) {
+            if (m_v != nullptr) build();
+        }
+
+        //! Copy constructor
+        select_support_sampled(const select_support_sampled &o) = default;
+
+        //! Move constructor
+        select_support_sampled(select_support_sampled &&o) = default;
+
+        //! Copy Operator=
+        select_support_sampled &operator=(const select_support_sampled &o) = default;
+
+        //! Move Operator=
+        select_support_sampled &operator=(select_support_sampled &&o) = default;
+
+        void swap(select_support_sampled &o) {
+            std::swap(m_sample_rate, o.m_sample_rate);
+            m_samples.swap(o.m_samples);
+        }
+
+        //Position of the i-th bit t_b, i >= 1
+        inline size_type select(size_type i) const {
+            uint64_t j = (i - 1) / m_sample_rate;
+            uint64_t pos = m_samples[j];
+            i -= j * m_sample_rate;
+            const uint64_t *data = m_v->data();
+            uint64_t k = pos / 64;
+            uint64_t w = word(data, k) & ~((1ULL << (pos % 64)) - 1);
+            uint64_t c = sdsl::bits::cnt(w);
+            while (c < i) {
+                i -= c;
+                w = word(data, ++k);
+                c = sdsl::bits::cnt(w);
+            }
+            return k * 64 + m_select_word(w, i);
+        }
+
+        inline size_type operator()(const size_type i) const {
+            return select(i);
+        }
+
+        void set_vector(const bit_vector_type *v = nullptr) {
+            m_v = v;
+        }
+
+        inline uint64_t sample_rate() const {
+            return m_sample_rate;
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+            size_type written_bytes = 0;
+            written_bytes += sdsl::write_member(m_sample_rate, out, child, "sample_rate");
+            written_bytes += m_samples.serialize(out, child, "samples");
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream &in, const bit_vector_type *v = nullptr) {
+            sdsl::read_member(m_sample_rate, in);
+            m_samples.load(in);
+            set_vector(v);
+        }
+    };
+}
+
+#endif //RING_SELECT_SUPPORT_SAMPLED_HPP
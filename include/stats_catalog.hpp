@@ -0,0 +1,155 @@
+/*
+ * stats_catalog.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RING_STATS_CATALOG_HPP
+#define RING_STATS_CATALOG_HPP
+
+#include <ostream>
+#include <string>
+#include <vector>
+#include "configuration.hpp"
+#include "index_format.hpp"
+
+namespace ring {
+
+    /*
+     * Counts the distinct values of each key while the pairs (key, value) are visited in an order where the
+     * values of each key are sorted, so equal values of a key are consecutive among the pairs of the key.
+     * Values are >= 1, as the identifiers of the triples.
+     */
+    class distinct_counter {
+
+    private:
+        std::vector<uint64_t> m_last; //last value of each key, 0 before the first one
+        sdsl::int_vector<> m_distinct;
+
+    public:
+        //@param max_key    Largest key
+        distinct_counter(const uint64_t max_key) : m_last(max_key + 1, 0), m_distinct(max_key + 1, 0, 64) {}
+
+        inline void add(const uint64_t key, const uint64_t value) {
+            if (m_last[key] != value) {
+                m_last[key] = value;
+                m_distinct[key] = m_distinct[key] + 1;
+            }
+        }
+
+        //Distinct values of each key
+        inline sdsl::int_vector<> &distinct() {
+            return m_distinct;
+        }
+    };
+
+    /*
+     * Statistics of the triples computed when the index is built, for the cost-based GAO (see
+     * gao::gao_cost): the number of distinct subjects and objects of each predicate, and of the whole
+     * graph. The number of triples of a predicate is given by the index itself, so the average out and in
+     * degrees of a predicate are its triples divided by its distinct subjects and objects.
+     */
+    class stats_catalog {
+
+    public:
+        typedef uint64_t size_type;
+
+    private:
+        sdsl::int_vector<> m_distinct_s; //m_distinct_s[p]: distinct subjects of the triples with predicate p
+        sdsl::int_vector<> m_distinct_o;
+        size_type m_n_subjects = 0;
+        size_type m_n_objects = 0;
+        size_type m_n_predicates = 0;
+
+    public:
+        stats_catalog() = default;
+
+        /**
+         * @param distinct_s    Distinct subjects of each predicate
+         * @param distinct_o    Distinct objects of each predicate
+         * @param n_subjects    Distinct subjects of the graph
+         * @param n_objects     Distinct objects of the graph
+         */
+        stats_catalog(sdsl::int_vector<> &distinct_s, sdsl::int_vector<> &distinct_o,
+                      const size_type n_subjects, const size_type n_objects)
+                : m_n_subjects(n_subjects), m_n_objects(n_objects) {
+            sdsl::util::bit_compress(distinct_s);
+            sdsl::util::bit_compress(distinct_o);
+            m_distinct_s.swap(distinct_s);
+            m_distinct_o.swap(distinct_o);
+            for (size_type p = 0; p < m_distinct_s.size(); ++p) {
+                if (m_distinct_s[p] > 0) ++m_n_predicates;
+            }
+        }
+
+        void swap(stats_catalog &o) {
+            m_distinct_s.swap(o.m_distinct_s);
+            m_distinct_o.swap(o.m_distinct_o);
+            std::swap(m_n_subjects, o.m_n_subjects);
+            std::swap(m_n_objects, o.m_n_objects);
+            std::swap(m_n_predicates, o.m_n_predicates);
+        }
+
+        //False for indexes built before the statistics were added
+        inline bool empty() const {
+            return m_distinct_s.empty();
+        }
+
+        inline size_type distinct_s(const uint64_t p) const {
+            return p < m_distinct_s.size() ? m_distinct_s[p] : 0;
+        }
+
+        inline size_type distinct_o(const uint64_t p) const {
+            return p < m_distinct_o.size() ? m_distinct_o[p] : 0;
+        }
+
+        inline size_type n_subjects() const {
+            return m_n_subjects;
+        }
+
+        inline size_type n_objects() const {
+            return m_n_objects;
+        }
+
+        inline size_type n_predicates() const {
+            return m_n_predicates;
+        }
+
+        void print_stats(std::ostream &out) const {
+            if (empty()) {
+                out << "Statistics: not stored in the index" << std::endl;
+                return;
+            }
+            out << "Statistics: " << m_n_subjects << " subjects, " << m_n_predicates << " predicates, "
+                << m_n_objects << " objects, " << sdsl::size_in_bytes(m_distinct_s) + sdsl::size_in_bytes(m_distinct_o)
+                << " bytes" << std::endl;
+        }
+
+        //Calls f.optional(name, component) for each component, since older indexes do not have them
+        //(see index_format)
+        template<class t_catalog, class t_f>
+        static void sections(t_catalog &c, const std::string &prefix, t_f &f) {
+            f.optional(prefix + "distinct_s", c.m_distinct_s);
+            f.optional(prefix + "distinct_o", c.m_distinct_o);
+            f.optional(prefix + "n_subjects", c.m_n_subjects);
+            f.optional(prefix + "n_objects", c.m_n_objects);
+            f.optional(prefix + "n_predicates", c.m_n_predicates);
+        }
+    };
+}
+
+#endif //RING_STATS_CATALOG_HPP
@@ -0,0 +1,329 @@
+/*
+ * triple_io.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_TRIPLE_IO_HPP
+#define RING_TRIPLE_IO_HPP
+
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "configuration.hpp"
+#include "mapped_file.hpp"
+#include "parallel.hpp"
+
+namespace ring {
+
+    /*
+     * Binary format of the triples: a header followed by the columns S, P and O, each one with the
+     * n values of the triples stored as unsigned integers of width bytes in native byte order. The
+     * identifiers of spo_triple have 32 bits, so width is always 4.
+     */
+    typedef struct {
+        char magic[8];
+        uint64_t version;
+        uint64_t n;
+        uint64_t width;
+    } triple_file_header;
+
+    const char triple_file_magic[8] = {'R', 'I', 'N', 'G', 'T', 'R', 'P', '\0'};
+    const uint64_t triple_file_version = 1;
+
+    inline bool is_binary_triple_file(const std::string &file) {
+        std::ifstream in(file, std::ios::binary);
+        char magic[sizeof(triple_file_magic)];
+        return in.read(magic, sizeof(magic)) && std::memcmp(magic, triple_file_magic, sizeof(magic)) == 0;
+    }
+
+    /**
+     * Parses a line of a text file of triples: three identifiers separated by blanks.
+     *
+     * @param begin     First character of the line
+     * @param end       Character after the last one, without the end of line
+     * @param t         Triple of the line
+     * @return          False if the line is blank
+     * @throws std::runtime_error if the line is not a triple or an identifier does not fit in 32 bits
+     */
+    inline bool parse_triple_line(const char *begin, const char *end, spo_triple &t) {
+        auto is_blank = [](const char c) { return c == ' ' || c == '\t' || c == '\r'; };
+        uint64_t v[3];
+        uint64_t k = 0;
+        const char *p = begin;
+        while (true) {
+            while (p < end && is_blank(*p)) ++p;
+            if (p == end) break;
+            if (k == 3 || *p < '0' || *p > '9') {
+                throw std::runtime_error("Malformed triple: " + std::string(begin, end));
+            }
+            uint64_t x = 0;
+            while (p < end && *p >= '0' && *p <= '9') {
+                x = x * 10 + (*p - '0');
+                if (x > std::numeric_limits<uint32_t>::max()) {
+                    throw std::runtime_error("Identifier of more than 32 bits: " + std::string(begin, end));
+                }
+                ++p;
+            }
+            if (p < end && !is_blank(*p)) throw std::runtime_error("Malformed triple: " + std::string(begin, end));
+            v[k++] = x;
+        }
+        if (k == 0) return false;
+        if (k != 3) throw std::runtime_error("Malformed triple: " + std::string(begin, end));
+        t = spo_triple(v[0], v[1], v[2]);
+        return true;
+    }
+
+    //Reads the triples of a text file with one "s p o" triple per line
+    class text_triple_reader {
+
+    private:
+        std::ifstream m_in;
+        std::string m_line;
+
+    public:
+        text_triple_reader(const std::string &file) : m_in(file) {}
+
+        bool is_open() const {
+            return m_in.is_open();
+        }
+
+        //Reads the next triple, skipping blank lines. Returns false at the end of the file, and throws
+        //std::runtime_error on a line that is not a triple (see parse_triple_line)
+        bool next(spo_triple &t) {
+            while (std::getline(m_in, m_line)) {
+                if (parse_triple_line(m_line.data(), m_line.data() + m_line.size(), t)) return true;
+            }
+            return false;
+        }
+    };
+
+    //Reads the triples of a file in the binary format
+    class binary_triple_reader {
+
+    private:
+        mapped_file m_file;
+        triple_file_header m_header;
+        const char *m_columns[3];
+        uint64_t m_pos = 0;
+        uint64_t m_released = 0; //triples whose pages next has released
+
+        static const uint64_t release_block = 1ULL << 20;
+
+    public:
+        binary_triple_reader(const std::string &file) : m_file(file, MADV_SEQUENTIAL) {
+            if (m_file.size() < sizeof(triple_file_header)) throw std::runtime_error("Truncated file " + file);
+            std::memcpy(&m_header, m_file.data(), sizeof(triple_file_header));
+            if (std::memcmp(m_header.magic, triple_file_magic, sizeof(triple_file_magic)) != 0
+                || m_header.version != triple_file_version
+                || m_file.size() < sizeof(triple_file_header) + 3 * m_header.n * m_header.width) {
+                throw std::runtime_error("Invalid binary triple file " + file);
+            }
+            if (m_header.width != sizeof(uint32_t)) {
+                throw std::runtime_error("The identifiers of " + file + " do not fit in 32 bits");
+            }
+            for (uint64_t c = 0; c < 3; ++c) {
+                m_columns[c] = m_file.data() + sizeof(triple_file_header) + c * m_header.n * m_header.width;
+            }
+        }
+
+        inline uint64_t size() const {
+            return m_header.n;
+        }
+
+        //Value of the i-th triple in the column c (0 = S, 1 = P, 2 = O)
+        inline uint32_t value(const uint64_t c, const uint64_t i) const {
+            return ((const uint32_t *) m_columns[c])[i];
+        }
+
+        inline spo_triple triple(const uint64_t i) const {
+            return spo_triple(value(0, i), value(1, i), value(2, i));
+        }
+
+        //Reads the next triple. Returns false at the end of the file. The pages already read are released
+        //every release_block triples, so a sequential read does not keep the file in memory
+        bool next(spo_triple &t) {
+            if (m_pos == m_header.n) return false;
+            if (m_pos - m_released == release_block) {
+                for (uint64_t c = 0; c < 3; ++c) {
+                    uint64_t column = m_columns[c] - m_file.data();
+                    m_file.release(column + m_released * m_header.width, column + m_pos * m_header.width);
+                }
+                m_released = m_pos;
+            }
+            t = triple(m_pos++);
+            return true;
+        }
+    };
+
+    //Reads the triples of a file either in the text or in the binary format
+    class triple_reader {
+
+    private:
+        std::unique_ptr<text_triple_reader> m_text;
+        std::unique_ptr<binary_triple_reader> m_binary;
+
+    public:
+        triple_reader(const std::string &file) {
+            if (is_binary_triple_file(file)) {
+                m_binary.reset(new binary_triple_reader(file));
+            } else {
+                m_text.reset(new text_triple_reader(file));
+            }
+        }
+
+        inline bool next(spo_triple &t) {
+            return m_binary ? m_binary->next(t) : m_text->next(t);
+        }
+    };
+
+    /**
+     * Parses the triples of a fragment of a text file, made of complete lines.
+     *
+     * @param begin     First character
+     * @param end       Character after the last one
+     * @param D         Vector where the triples are appended
+     * @throws std::runtime_error on a line that is not a triple (see parse_triple_line)
+     */
+    inline void parse_triples(const char *begin, const char *end, std::vector<spo_triple> &D) {
+        spo_triple t;
+        const char *p = begin;
+        while (p < end) {
+            const char *line_end = (const char *) std::memchr(p, '\n', end - p);
+            if (line_end == nullptr) line_end = end;
+            if (parse_triple_line(p, line_end, t)) D.push_back(t);
+            p = line_end + 1;
+        }
+    }
+
+    /**
+     * Reads all the triples of a file. Binary files are mapped and copied column by column; text files are
+     * mapped and split in chunks of complete lines that are parsed in parallel.
+     *
+     * @param file      File with the triples
+     * @param D         Vector where the triples are stored, in the order of the file
+     * @param n_threads Maximum number of threads
+     * @throws std::runtime_error if the file is not valid
+     */
+    inline void read_triples(const std::string &file, std::vector<spo_triple> &D, const uint64_t n_threads = 1) {
+        uint64_t n_chunks = std::max<uint64_t>(n_threads, 1);
+        if (is_binary_triple_file(file)) {
+            binary_triple_reader reader(file);
+            uint64_t n = reader.size();
+            D.resize(n);
+            std::vector<parallel::task_type> tasks;
+            for (uint64_t k = 0; k < n_chunks; ++k) {
+                uint64_t b = n * k / n_chunks, e = n * (k + 1) / n_chunks;
+                tasks.emplace_back([&reader, &D, b, e]() {
+                    for (uint64_t i = b; i < e; ++i) D[i] = reader.triple(i);
+                });
+            }
+            parallel::run_tasks(tasks, n_threads);
+            return;
+        }
+
+        mapped_file text(file, MADV_SEQUENTIAL);
+        const char *data = text.data();
+        uint64_t size = text.size();
+        std::vector<uint64_t> bounds(n_chunks + 1, size);
+        bounds[0] = 0;
+        for (uint64_t k = 1; k < n_chunks; ++k) {
+            uint64_t b = std::max(size * k / n_chunks, bounds[k-1]);
+            while (b > 0 && b < size && data[b-1] != '\n') ++b;
+            bounds[k] = b;
+        }
+        std::vector<std::vector<spo_triple>> chunks(n_chunks);
+        std::vector<std::exception_ptr> errors(n_chunks);
+        std::vector<parallel::task_type> tasks;
+        for (uint64_t k = 0; k < n_chunks; ++k) {
+            tasks.emplace_back([&chunks, &errors, &bounds, data, k]() {
+                try {
+                    chunks[k].reserve((bounds[k+1] - bounds[k]) / 8);
+                    parse_triples(data + bounds[k], data + bounds[k+1], chunks[k]);
+                } catch (...) {
+                    errors[k] = std::current_exception();
+                }
+            });
+        }
+        parallel::run_tasks(tasks, n_threads);
+        for (const auto &e : errors) {
+            if (e) std::rethrow_exception(e);
+        }
+
+        if (n_chunks == 1) {
+            D.swap(chunks[0]);
+        } else {
+            uint64_t n = 0;
+            for (const auto &c : chunks) n += c.size();
+            D.reserve(n);
+            for (auto &c : chunks) {
+                D.insert(D.end(), c.begin(), c.end());
+                std::vector<spo_triple>().swap(c);
+            }
+        }
+        D.shrink_to_fit();
+    }
+
+    /**
+     * Converts a file of triples in the text format to the binary format. The text file is read twice
+     * and the triples are not kept in memory.
+     *
+     * @param text_file     Input file with one "s p o" triple per line
+     * @param binary_file   Output file
+     * @return              Number of triples
+     * @throws std::runtime_error if the text file is not valid (see parse_triple_line)
+     */
+    inline uint64_t convert_to_binary(const std::string &text_file, const std::string &binary_file) {
+        triple_file_header header;
+        std::memcpy(header.magic, triple_file_magic, sizeof(triple_file_magic));
+        header.version = triple_file_version;
+        header.n = 0;
+        header.width = sizeof(uint32_t);
+        spo_triple t;
+        {
+            text_triple_reader reader(text_file);
+            if (!reader.is_open()) throw std::runtime_error("Cannot open " + text_file);
+            while (reader.next(t)) ++header.n;
+        }
+        {
+            std::ofstream out(binary_file, std::ios::binary | std::ios::trunc);
+            if (!out) throw std::runtime_error("Cannot create " + binary_file);
+            out.write((const char *) &header, sizeof(header));
+        }
+
+        // One stream per column, each one positioned at the beginning of its column
+        std::fstream columns[3];
+        for (uint64_t c = 0; c < 3; ++c) {
+            columns[c].open(binary_file, std::ios::in | std::ios::out | std::ios::binary);
+            columns[c].seekp(sizeof(header) + c * header.n * header.width);
+        }
+        text_triple_reader reader(text_file);
+        while (reader.next(t)) {
+            uint32_t v[3] = {std::get<0>(t), std::get<1>(t), std::get<2>(t)};
+            for (uint64_t c = 0; c < 3; ++c) {
+                columns[c].write((const char *) &v[c], sizeof(v[c]));
+            }
+        }
+        return header.n;
+    }
+}
+
+#endif //RING_TRIPLE_IO_HPP
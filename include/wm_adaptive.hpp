@@ -0,0 +1,682 @@
+/*
+ * wm_adaptive.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RING_WM_ADAPTIVE_HPP
+#define RING_WM_ADAPTIVE_HPP
+
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "configuration.hpp"
+#include "index_format.hpp"
+#include "wm_cursor.hpp"
+
+namespace ring {
+
+    /*
+     * Level of a wm_adaptive: a bitvector with rank and select stored as a plain bitvector, an RRR vector,
+     * or a sparse (Elias-Fano) vector of the positions of its ones or of its zeros.
+     */
+    class wm_level {
+
+    public:
+        typedef uint64_t size_type;
+
+        enum encoding_type : uint64_t {
+            plain = 0,
+            rrr = 1,
+            sparse = 2,         //positions of the ones
+            sparse_zeros = 3    //positions of the zeros
+        };
+
+        typedef sdsl::rrr_vector<15> rrr_type;
+        typedef sdsl::sd_vector<> sd_type;
+
+        //Relative cost of accessing each encoding: a level takes the encoding of least bytes * weight
+        static double cost_weight(const uint64_t encoding) {
+            switch (encoding) {
+                case plain: return 1.0;
+                case rrr: return 2.0;
+                default: return 1.5;
+            }
+        }
+
+    private:
+        uint64_t m_encoding = plain;
+        size_type m_size = 0;
+        sdsl::bit_vector m_plain;
+        sdsl::rank_support_v<> m_plain_rank;
+        sdsl::select_support_mcl<1> m_plain_select1;
+        sdsl::select_support_mcl<0> m_plain_select0;
+        rrr_type m_rrr;
+        rrr_type::rank_1_type m_rrr_rank;
+        rrr_type::select_1_type m_rrr_select1;
+        rrr_type::select_0_type m_rrr_select0;
+        sd_type m_sd;
+        sd_type::rank_1_type m_sd_rank;
+        sd_type::select_1_type m_sd_select1;
+        sd_type::select_0_type m_sd_select0;
+
+        void set_vectors() {
+            m_plain_rank.set_vector(&m_plain);
+            m_plain_select1.set_vector(&m_plain);
+            m_plain_select0.set_vector(&m_plain);
+            m_rrr_rank.set_vector(&m_rrr);
+            m_rrr_select1.set_vector(&m_rrr);
+            m_rrr_select0.set_vector(&m_rrr);
+            m_sd_rank.set_vector(&m_sd);
+            m_sd_select1.set_vector(&m_sd);
+            m_sd_select0.set_vector(&m_sd);
+        }
+
+        void copy(const wm_level &o) {
+            m_encoding = o.m_encoding;
+            m_size = o.m_size;
+            m_plain = o.m_plain;
+            m_plain_rank = o.m_plain_rank;
+            m_plain_select1 = o.m_plain_select1;
+            m_plain_select0 = o.m_plain_select0;
+            m_rrr = o.m_rrr;
+            m_rrr_rank = o.m_rrr_rank;
+            m_rrr_select1 = o.m_rrr_select1;
+            m_rrr_select0 = o.m_rrr_select0;
+            m_sd = o.m_sd;
+            m_sd_rank = o.m_sd_rank;
+            m_sd_select1 = o.m_sd_select1;
+            m_sd_select0 = o.m_sd_select0;
+            set_vectors();
+        }
+
+        static const uint64_t rrr_block = 15;      //bits per block of rrr_type
+        static const uint64_t rrr_sample = 32;     //blocks per sample of rrr_type
+
+        //Bits of the offset of an RRR block with k ones: ceil(log2(binomial(15, k)))
+        static uint64_t rrr_offset_width(const uint64_t k) {
+            static const uint8_t widths[rrr_block + 1] = {0, 4, 7, 9, 11, 12, 13, 13, 13, 13, 12, 11, 9, 7, 4, 0};
+            return widths[k];
+        }
+
+        //Estimated bits of select_support_mcl over n bits with k of the selected bit: a sample per 4096
+        //occurrences, and in each superblock either every 64th offset or, if it is long, every position
+        static uint64_t mcl_bits(const uint64_t n, const uint64_t k) {
+            if (k == 0) return 0;
+            uint64_t superblocks = (k + 4095) / 4096;
+            uint64_t log_n = sdsl::bits::hi(n) + 1;
+            uint64_t length = n / superblocks + 1;
+            if (length > log_n * log_n * log_n * log_n) {
+                return superblocks * (64 + 4096 * log_n);
+            }
+            return superblocks * (64 + 64 * (sdsl::bits::hi(length) + 1));
+        }
+
+        //Estimated bits of the bitvector with rank_support_v (two words per 512 bits) and both selects
+        static uint64_t plain_bits(const uint64_t n, const uint64_t ones) {
+            return ((n + 63) / 64) * 64 + (n / 512 + 1) * 128 + mcl_bits(n, ones) + mcl_bits(n, n - ones);
+        }
+
+        //Bits of the RRR vector: the class of each block, the offsets, and per sample a pointer and a rank.
+        //Its rank and select supports take no space
+        static uint64_t rrr_bits(const uint64_t n, const uint64_t offset_bits) {
+            uint64_t blocks = (n + rrr_block - 1) / rrr_block;
+            return blocks * 4 + offset_bits + (blocks / rrr_sample + 1) * 128;
+        }
+
+        //Estimated bits of the sparse vector of m positions: the low bits, the unary high bits and the two
+        //select_support_mcl over them. Its rank and select supports take no space
+        static uint64_t sd_bits(const uint64_t n, const uint64_t m) {
+            uint64_t low_width = (m > 0 && n / m > 1) ? sdsl::bits::hi(n / m) : 0;
+            uint64_t high = m + (n >> low_width) + 1;
+            return m * low_width + high + mcl_bits(high, m) + mcl_bits(high, high - m);
+        }
+
+    public:
+        wm_level() = default;
+
+        //Builds the level with the encoding of least cost (see cost_weight). The sizes of the three encodings
+        //are estimated from the layout of sdsl (see plain_bits, rrr_bits and sd_bits), and only the chosen
+        //one is built
+        wm_level(const sdsl::bit_vector &bv) : m_size(bv.size()) {
+            uint64_t ones = 0, offset_bits = 0;
+            for (uint64_t i = 0; i < m_size; i += rrr_block) {
+                uint64_t length = m_size - i < rrr_block ? m_size - i : rrr_block;
+                uint64_t k = sdsl::bits::cnt(bv.get_int(i, length));
+                ones += k;
+                offset_bits += rrr_offset_width(k);
+            }
+            //The sparse vector stores the positions of the minority bit
+            bool zeros = 2 * ones > m_size;
+
+            double best = cost_weight(plain) * plain_bits(m_size, ones);
+            m_encoding = plain;
+            double cost = cost_weight(rrr) * rrr_bits(m_size, offset_bits);
+            if (cost < best) {
+                best = cost;
+                m_encoding = rrr;
+            }
+            cost = cost_weight(sparse) * sd_bits(m_size, zeros ? m_size - ones : ones);
+            if (cost < best) {
+                best = cost;
+                m_encoding = zeros ? sparse_zeros : sparse;
+            }
+
+            if (m_encoding == plain) {
+                m_plain = bv;
+                sdsl::util::init_support(m_plain_rank, &m_plain);
+                sdsl::util::init_support(m_plain_select1, &m_plain);
+                sdsl::util::init_support(m_plain_select0, &m_plain);
+            } else if (m_encoding == rrr) {
+                m_rrr = rrr_type(bv);
+                sdsl::util::init_support(m_rrr_rank, &m_rrr);
+                sdsl::util::init_support(m_rrr_select1, &m_rrr);
+                sdsl::util::init_support(m_rrr_select0, &m_rrr);
+            } else {
+                if (zeros) {
+                    sdsl::bit_vector minority(bv);
+                    minority.flip();
+                    m_sd = sd_type(minority);
+                } else {
+                    m_sd = sd_type(bv);
+                }
+                sdsl::util::init_support(m_sd_rank, &m_sd);
+                sdsl::util::init_support(m_sd_select1, &m_sd);
+                sdsl::util::init_support(m_sd_select0, &m_sd);
+            }
+            set_vectors();
+        }
+
+        //! Copy constructor
+        wm_level(const wm_level &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        wm_level(wm_level &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        wm_level &operator=(const wm_level &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        wm_level &operator=(wm_level &&o) {
+            if (this != &o) {
+                swap(o);
+            }
+            return *this;
+        }
+
+        void swap(wm_level &o) {
+            std::swap(m_encoding, o.m_encoding);
+            std::swap(m_size, o.m_size);
+            m_plain.swap(o.m_plain);
+            sdsl::util::swap_support(m_plain_rank, o.m_plain_rank, &m_plain, &o.m_plain);
+            sdsl::util::swap_support(m_plain_select1, o.m_plain_select1, &m_plain, &o.m_plain);
+            sdsl::util::swap_support(m_plain_select0, o.m_plain_select0, &m_plain, &o.m_plain);
+            m_rrr.swap(o.m_rrr);
+            sdsl::util::swap_support(m_rrr_rank, o.m_rrr_rank, &m_rrr, &o.m_rrr);
+            sdsl::util::swap_support(m_rrr_select1, o.m_rrr_select1, &m_rrr, &o.m_rrr);
+            sdsl::util::swap_support(m_rrr_select0, o.m_rrr_select0, &m_rrr, &o.m_rrr);
+            m_sd.swap(o.m_sd);
+            sdsl::util::swap_support(m_sd_rank, o.m_sd_rank, &m_sd, &o.m_sd);
+            sdsl::util::swap_support(m_sd_select1, o.m_sd_select1, &m_sd, &o.m_sd);
+            sdsl::util::swap_support(m_sd_select0, o.m_sd_select0, &m_sd, &o.m_sd);
+        }
+
+        inline uint64_t encoding() const {
+            return m_encoding;
+        }
+
+        static std::string encoding_name(const uint64_t encoding) {
+            switch (encoding) {
+                case plain: return "plain";
+                case rrr: return "rrr";
+                case sparse: return "sparse";
+                default: return "sparse-zeros";
+            }
+        }
+
+        inline size_type size() const {
+            return m_size;
+        }
+
+        inline uint64_t operator[](const size_type i) const {
+            switch (m_encoding) {
+                case plain: return m_plain[i];
+                case rrr: return m_rrr[i];
+                case sparse: return m_sd[i];
+                default: return 1 - m_sd[i];
+            }
+        }
+
+        //Ones in [0, i)
+        inline size_type rank1(const size_type i) const {
+            switch (m_encoding) {
+                case plain: return m_plain_rank(i);
+                case rrr: return m_rrr_rank(i);
+                case sparse: return m_sd_rank(i);
+                default: return i - m_sd_rank(i);
+            }
+        }
+
+        //Position of the i-th one, i >= 1
+        inline size_type select1(const size_type i) const {
+            switch (m_encoding) {
+                case plain: return m_plain_select1(i);
+                case rrr: return m_rrr_select1(i);
+                case sparse: return m_sd_select1(i);
+                default: return m_sd_select0(i);
+            }
+        }
+
+        //Position of the i-th zero, i >= 1
+        inline size_type select0(const size_type i) const {
+            switch (m_encoding) {
+                case plain: return m_plain_select0(i);
+                case rrr: return m_rrr_select0(i);
+                case sparse: return m_sd_select0(i);
+                default: return m_sd_select1(i);
+            }
+        }
+
+        //Calls f(name, component) for each component, and f(name, support, bitvector) for the rank and
+        //select structures (see index_format)
+        template<class t_level, class t_f>
+        static void sections(t_level &l, const std::string &prefix, t_f &f) {
+            f(prefix + "encoding", l.m_encoding);
+            f(prefix + "size", l.m_size);
+            f(prefix + "plain", l.m_plain);
+            f(prefix + "plain_rank", l.m_plain_rank, &l.m_plain);
+            f(prefix + "plain_select1", l.m_plain_select1, &l.m_plain);
+            f(prefix + "plain_select0", l.m_plain_select0, &l.m_plain);
+            f(prefix + "rrr", l.m_rrr);
+            f(prefix + "rrr_rank", l.m_rrr_rank, &l.m_rrr);
+            f(prefix + "rrr_select1", l.m_rrr_select1, &l.m_rrr);
+            f(prefix + "rrr_select0", l.m_rrr_select0, &l.m_rrr);
+            f(prefix + "sd", l.m_sd);
+            f(prefix + "sd_rank", l.m_sd_rank, &l.m_sd);
+            f(prefix + "sd_select1", l.m_sd_select1, &l.m_sd);
+            f(prefix + "sd_select0", l.m_sd_select0, &l.m_sd);
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+            size_type written_bytes = 0;
+            written_bytes += sdsl::write_member(m_encoding, out, child, "encoding");
+            written_bytes += sdsl::write_member(m_size, out, child, "size");
+            written_bytes += m_plain.serialize(out, child, "plain");
+            written_bytes += m_plain_rank.serialize(out, child, "plain_rank");
+            written_bytes += m_plain_select1.serialize(out, child, "plain_select1");
+            written_bytes += m_plain_select0.serialize(out, child, "plain_select0");
+            written_bytes += m_rrr.serialize(out, child, "rrr");
+            written_bytes += m_rrr_rank.serialize(out, child, "rrr_rank");
+            written_bytes += m_rrr_select1.serialize(out, child, "rrr_select1");
+            written_bytes += m_rrr_select0.serialize(out, child, "rrr_select0");
+            written_bytes += m_sd.serialize(out, child, "sd");
+            written_bytes += m_sd_rank.serialize(out, child, "sd_rank");
+            written_bytes += m_sd_select1.serialize(out, child, "sd_select1");
+            written_bytes += m_sd_select0.serialize(out, child, "sd_select0");
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream &in) {
+            sdsl::read_member(m_encoding, in);
+            sdsl::read_member(m_size, in);
+            m_plain.load(in);
+            m_plain_rank.load(in, &m_plain);
+            m_plain_select1.load(in, &m_plain);
+            m_plain_select0.load(in, &m_plain);
+            m_rrr.load(in);
+            m_rrr_rank.load(in, &m_rrr);
+            m_rrr_select1.load(in, &m_rrr);
+            m_rrr_select0.load(in, &m_rrr);
+            m_sd.load(in);
+            m_sd_rank.load(in, &m_sd);
+            m_sd_select1.load(in, &m_sd);
+            m_sd_select0.load(in, &m_sd);
+        }
+    };
+
+    /*
+     * Wavelet matrix with the interface of wm_int used by bwt, whose levels are stored separately, each
+     * one with the encoding that suits it (see wm_level). The top levels of the BWTs are close to balanced
+     * and stay plain, while the deep levels are skewed and are compressed.
+     */
+    class wm_adaptive {
+
+    public:
+        typedef uint64_t size_type;
+        typedef uint64_t value_type;
+
+    private:
+        static const uint64_t not_found = (uint64_t) -1;
+
+        size_type m_size = 0;
+        size_type m_sigma = 0;
+        uint64_t m_max_level = 0;
+        std::vector<wm_level> m_levels;
+        sdsl::int_vector<64> m_zero_cnt;
+
+        inline uint64_t bit(const uint64_t c, const uint64_t k) const {
+            return (c >> (m_max_level - 1 - k)) & 1ULL;
+        }
+
+        //Smallest value >= y below the node [b, e) of the level k whose prefix is value
+        uint64_t next_value(const uint64_t k, const uint64_t b, const uint64_t e, const uint64_t value,
+                            const uint64_t y, const bool tight) const {
+            if (k == m_max_level) return value;
+            const wm_level &level = m_levels[k];
+            uint64_t ones_b = level.rank1(b), ones_e = level.rank1(e);
+            bool has_ones = ones_e > ones_b;
+            bool has_zeros = (e - b) > (ones_e - ones_b);
+            if (!tight || bit(y, k) == 0) {
+                if (has_zeros) {
+                    uint64_t res = next_value(k + 1, b - ones_b, e - ones_e, value << 1, y, tight);
+                    if (res != not_found) return res;
+                }
+                if (has_ones) {
+                    return next_value(k + 1, m_zero_cnt[k] + ones_b, m_zero_cnt[k] + ones_e, (value << 1) | 1ULL,
+                                      y, false);
+                }
+                return not_found;
+            }
+            if (has_ones) {
+                return next_value(k + 1, m_zero_cnt[k] + ones_b, m_zero_cnt[k] + ones_e, (value << 1) | 1ULL,
+                                  y, true);
+            }
+            return not_found;
+        }
+
+        void values(const uint64_t k, const uint64_t b, const uint64_t e, const uint64_t value,
+                    std::vector<value_type> &res) const {
+            if (k == m_max_level) {
+                res.push_back(value);
+                return;
+            }
+            const wm_level &level = m_levels[k];
+            uint64_t ones_b = level.rank1(b), ones_e = level.rank1(e);
+            if ((e - b) > (ones_e - ones_b)) values(k + 1, b - ones_b, e - ones_e, value << 1, res);
+            if (ones_e > ones_b) values(k + 1, m_zero_cnt[k] + ones_b, m_zero_cnt[k] + ones_e, (value << 1) | 1ULL, res);
+        }
+
+    public:
+        wm_adaptive() = default;
+
+        template<uint8_t int_width>
+        wm_adaptive(sdsl::int_vector_buffer<int_width> &buf, const size_type size) : m_size(size) {
+            if (m_size == 0) return;
+            uint64_t max = 0;
+            for (size_type i = 0; i < m_size; ++i) max = std::max<uint64_t>(max, buf[i]);
+            m_sigma = max + 1;
+            m_max_level = max ? sdsl::bits::hi(max) + 1 : 1;
+            sdsl::int_vector<> cur(m_size, 0, m_max_level);
+            for (size_type i = 0; i < m_size; ++i) cur[i] = buf[i];
+            sdsl::int_vector<> next(m_size, 0, m_max_level);
+            m_zero_cnt = sdsl::int_vector<64>(m_max_level, 0);
+            m_levels.resize(m_max_level);
+            for (uint64_t k = 0; k < m_max_level; ++k) {
+                sdsl::bit_vector bv(m_size, 0);
+                uint64_t zeros = 0;
+                for (size_type i = 0; i < m_size; ++i) {
+                    if (bit(cur[i], k)) bv[i] = 1; else ++zeros;
+                }
+                //Stable partition: zeros first
+                uint64_t z = 0, o = zeros;
+                for (size_type i = 0; i < m_size; ++i) {
+                    if (bv[i]) next[o++] = cur[i]; else next[z++] = cur[i];
+                }
+                cur.swap(next);
+                m_zero_cnt[k] = zeros;
+                wm_level level(bv);
+                m_levels[k].swap(level);
+            }
+        }
+
+        //! Copy constructor
+        wm_adaptive(const wm_adaptive &o) = default;
+
+        //! Move constructor
+        wm_adaptive(wm_adaptive &&o) = default;
+
+        //! Copy Operator=
+        wm_adaptive &operator=(const wm_adaptive &o) = default;
+
+        //! Move Operator=
+        wm_adaptive &operator=(wm_adaptive &&o) = default;
+
+        void swap(wm_adaptive &o) {
+            std::swap(m_size, o.m_size);
+            std::swap(m_sigma, o.m_sigma);
+            std::swap(m_max_level, o.m_max_level);
+            m_levels.swap(o.m_levels);
+            m_zero_cnt.swap(o.m_zero_cnt);
+        }
+
+        inline size_type size() const {
+            return m_size;
+        }
+
+        inline bool empty() const {
+            return m_size == 0;
+        }
+
+        inline uint64_t levels() const {
+            return m_max_level;
+        }
+
+        inline const wm_level &level(const uint64_t k) const {
+            return m_levels[k];
+        }
+
+        value_type operator[](size_type i) const {
+            value_type res = 0;
+            for (uint64_t k = 0; k < m_max_level; ++k) {
+                const wm_level &level = m_levels[k];
+                uint64_t b = level[i];
+                uint64_t ones = level.rank1(i);
+                i = b ? m_zero_cnt[k] + ones : i - ones;
+                res = (res << 1) | b;
+            }
+            return res;
+        }
+
+        //Occurrences of c in [0, i)
+        size_type rank(size_type i, const value_type c) const {
+            return rank_pair(0, i, c).second;
+        }
+
+        //{rank(i, c), rank(j, c)} with one descent, i <= j
+        std::pair<size_type, size_type> rank_pair(size_type i, size_type j, const value_type c) const {
+            if (m_max_level < 64 && (c >> m_max_level) != 0) return {0, 0};
+            uint64_t b = 0; //beginning of the node, i and j are relative to it
+            for (uint64_t k = 0; k < m_max_level && j > 0; ++k) {
+                const wm_level &level = m_levels[k];
+                uint64_t ones_b = level.rank1(b), ones_i = level.rank1(b + i), ones_j = level.rank1(b + j);
+                if (bit(c, k)) {
+                    i = ones_i - ones_b;
+                    j = ones_j - ones_b;
+                    b = m_zero_cnt[k] + ones_b;
+                } else {
+                    i = i - (ones_i - ones_b);
+                    j = j - (ones_j - ones_b);
+                    b = b - ones_b;
+                }
+            }
+            return {i, j};
+        }
+
+        //Position of the i-th occurrence of c, i >= 1
+        size_type select(size_type i, const value_type c) const {
+            if (m_max_level < 64 && (c >> m_max_level) != 0) return m_size;
+            uint64_t b = 0;
+            for (uint64_t k = 0; k < m_max_level; ++k) {
+                uint64_t ones_b = m_levels[k].rank1(b);
+                b = bit(c, k) ? m_zero_cnt[k] + ones_b : b - ones_b;
+            }
+            uint64_t p = b + i - 1;
+            for (uint64_t k = m_max_level; k-- > 0;) {
+                const wm_level &level = m_levels[k];
+                p = bit(c, k) ? level.select1(p - m_zero_cnt[k] + 1) : level.select0(p + 1);
+            }
+            return p;
+        }
+
+        //{rank(i, L[i]), L[i]}
+        std::pair<size_type, value_type> inverse_select(size_type i) const {
+            value_type c = 0;
+            uint64_t b = 0;
+            for (uint64_t k = 0; k < m_max_level; ++k) {
+                const wm_level &level = m_levels[k];
+                uint64_t x = level[b + i];
+                uint64_t ones_b = level.rank1(b), ones_p = level.rank1(b + i);
+                if (x) {
+                    i = ones_p - ones_b;
+                    b = m_zero_cnt[k] + ones_b;
+                } else {
+                    i = i - (ones_p - ones_b);
+                    b = b - ones_b;
+                }
+                c = (c << 1) | x;
+            }
+            return {i, c};
+        }
+
+        //{position of the next occurrence of val after the first pos ones, its rank}, or {0, 0}
+        std::pair<size_type, size_type> select_next(size_type pos, value_type val, size_type n_elems) const {
+            size_type r = rank(pos, val);
+            if (r >= n_elems) return {0, 0};
+            return {select(r + 1, val), r};
+        }
+
+        value_type range_minimum_query(size_type l, size_type r) const {
+            return range_next_value(0, l, r);
+        }
+
+        //Smallest value >= x in [l, r], or 0 if there is none
+        value_type range_next_value(value_type x, size_type l, size_type r) const {
+            if (l > r || r >= m_size || x >= m_sigma) return 0;
+            uint64_t res = next_value(0, l, r + 1, 0, x, true);
+            return res == not_found ? 0 : res;
+        }
+
+        //Distinct values in [l, r], in increasing order
+        std::vector<value_type> all_values_in_range(size_type l, size_type r) const {
+            std::vector<value_type> res;
+            if (l <= r && r < m_size) values(0, l, r + 1, 0, res);
+            return res;
+        }
+
+        //Writes the encoding and the size of each level
+        void print_stats(std::ostream &out, const std::string &prefix) const {
+            for (uint64_t k = 0; k < m_max_level; ++k) {
+                out << prefix << "level " << k << ": " << wm_level::encoding_name(m_levels[k].encoding())
+                    << ", " << sdsl::size_in_bytes(m_levels[k]) << " bytes" << std::endl;
+            }
+        }
+
+        //Calls f(name, component) for each component, and f(name, support, bitvector) for the rank and
+        //select structures (see index_format)
+        template<class t_wt, class t_f>
+        static void sections(t_wt &wt, const std::string &prefix, t_f &f) {
+            f(prefix + "size", wt.m_size);
+            f(prefix + "sigma", wt.m_sigma);
+            f(prefix + "max_level", wt.m_max_level);
+            f(prefix + "zero_cnt", wt.m_zero_cnt);
+            //The levels are created when they are read
+            const_cast<wm_adaptive &>(wt).m_levels.resize(wt.m_max_level);
+            for (uint64_t k = 0; k < wt.m_max_level; ++k) {
+                wm_level::sections(wt.m_levels[k], prefix + "level" + std::to_string(k) + ".", f);
+            }
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+            size_type written_bytes = 0;
+            written_bytes += sdsl::write_member(m_size, out, child, "size");
+            written_bytes += sdsl::write_member(m_sigma, out, child, "sigma");
+            written_bytes += sdsl::write_member(m_max_level, out, child, "max_level");
+            written_bytes += m_zero_cnt.serialize(out, child, "zero_cnt");
+            for (uint64_t k = 0; k < m_max_level; ++k) {
+                written_bytes += m_levels[k].serialize(out, child, "level" + std::to_string(k));
+            }
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream &in) {
+            sdsl::read_member(m_size, in);
+            sdsl::read_member(m_sigma, in);
+            sdsl::read_member(m_max_level, in);
+            m_zero_cnt.load(in);
+            m_levels.resize(m_max_level);
+            for (uint64_t k = 0; k < m_max_level; ++k) m_levels[k].load(in);
+        }
+    };
+
+    inline uint64_t wm_cursor::next_value(const wm_adaptive &wm, const uint64_t x, const uint64_t l, const uint64_t r) {
+        return wm.range_next_value(x, l, r);
+    }
+
+    //Writes the details of a wavelet matrix for the stats of an index; only wm_adaptive has them
+    template<class t_wm>
+    void wm_print_stats(const t_wm &, std::ostream &, const std::string &) {}
+
+    inline void wm_print_stats(const wm_adaptive &wm, std::ostream &out, const std::string &prefix) {
+        wm.print_stats(out, prefix);
+    }
+
+    inline std::pair<uint64_t, uint64_t> wm_rank_pair(const wm_adaptive &wm, const uint64_t i, const uint64_t j,
+                                                      const uint64_t c) {
+        return wm.rank_pair(i, j, c);
+    }
+
+    //The path of the select of wm_adaptive is already on the stack
+    inline uint64_t wm_select(const wm_adaptive &wm, const uint64_t i, const uint64_t c, const bool) {
+        return wm.select(i, c);
+    }
+
+    inline std::pair<uint64_t, uint64_t> wm_select_next(const wm_adaptive &wm, const uint64_t pos, const uint64_t val,
+                                                        const uint64_t n_elems, const bool) {
+        return wm.select_next(pos, val, n_elems);
+    }
+
+    namespace index_format {
+
+        template<class t_f>
+        void wm_sections(wm_adaptive &wm, const std::string &prefix, t_f &f) {
+            wm_adaptive::sections(wm, prefix, f);
+        }
+
+        template<class t_f>
+        void wm_sections(const wm_adaptive &wm, const std::string &prefix, t_f &f) {
+            wm_adaptive::sections(wm, prefix, f);
+        }
+    }
+}
+
+#endif //RING_WM_ADAPTIVE_HPP
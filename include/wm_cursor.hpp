@@ -0,0 +1,211 @@
+/*
+ * wm_cursor.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RING_WM_CURSOR_HPP
+#define RING_WM_CURSOR_HPP
+
+#include "configuration.hpp"
+#include "index_format.hpp"
+
+namespace ring {
+
+    template<class t_bv, class t_rank, class t_select_1, class t_select_0>
+    class wt_alphabetic;
+
+    template<class t_wm, class t_bv>
+    class wm_rle;
+
+    class wm_adaptive;
+
+    /*
+     * Cursor over a range [l, r] of a wavelet matrix that returns the smallest value >= x in the range,
+     * like wm_int::range_next_value. It keeps the nodes of the path to the last value found, so the next
+     * call only descends from the deepest node whose path is a prefix of the new x. The leapfrog asks
+     * for increasing values in the same range, which usually share the first levels. The path is a fixed
+     * array, so the cursor, and the bwt_interval that holds it, is copied without allocating; only the
+     * m_depth nodes in use are copied, which is none for a cursor that has not been used yet.
+     */
+    class wm_cursor {
+
+    private:
+        typedef struct {
+            uint64_t b;      //the node is [b, e) in its level
+            uint64_t e;
+            uint64_t ones_b; //ones before b and e in the level, unknown until the node is descended
+            uint64_t ones_e;
+        } node_type;
+
+        static const uint64_t unknown = (uint64_t) -1;
+
+        const void *m_wm = nullptr;
+        uint64_t m_l = 0;
+        uint64_t m_r = 0;
+        node_type m_path[65];          //m_path[k] is the node at level k
+        uint64_t m_depth = 0;          //nodes in m_path, 0 until the cursor is used
+        uint64_t m_value = 0;          //bits of the path, the bit of level k at position levels-1-k
+
+        static inline uint64_t bit(const uint64_t x, const uint64_t k, const uint64_t levels) {
+            return (x >> (levels - 1 - k)) & 1ULL;
+        }
+
+        inline void set_bit(const uint64_t k, const uint64_t levels, const uint64_t b) {
+            uint64_t mask = 1ULL << (levels - 1 - k);
+            m_value = b ? (m_value | mask) : (m_value & ~mask);
+        }
+
+        void copy(const wm_cursor &o) {
+            m_wm = o.m_wm;
+            m_l = o.m_l;
+            m_r = o.m_r;
+            m_depth = o.m_depth;
+            m_value = o.m_value;
+            for (uint64_t k = 0; k < m_depth; ++k) m_path[k] = o.m_path[k];
+        }
+
+    public:
+        wm_cursor() = default;
+
+        //! Copy constructor
+        wm_cursor(const wm_cursor &o) {
+            copy(o);
+        }
+
+        //! Copy Operator=
+        wm_cursor &operator=(const wm_cursor &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        void swap(wm_cursor &o) {
+            wm_cursor tmp(o);
+            o.copy(*this);
+            copy(tmp);
+        }
+
+        /**
+         * @param wm    Wavelet matrix
+         * @param x     Value
+         * @param l     Left end of the range
+         * @param r     Right end of the range
+         * @return      Smallest value >= x in wm[l..r], or 0 if there is none
+         */
+        template<class t_wm>
+        uint64_t next_value(const t_wm &wm, const uint64_t x, const uint64_t l, const uint64_t r) {
+            typedef index_format::wm_members<t_wm> members;
+            const uint64_t levels = wm.*members::max_level();
+            const uint64_t n = wm.*members::size();
+            const auto &tree_rank = wm.*members::tree_rank();
+            const auto &zero_cnt = wm.*members::zero_cnt();
+            const auto &rank_level = wm.*members::rank_level();
+
+            if (l > r || r >= n) return 0;
+            if (levels < 64 && (x >> levels) != 0) return 0;
+
+            if (m_wm != &wm || m_l != l || m_r != r || m_depth == 0) {
+                m_wm = &wm;
+                m_l = l;
+                m_r = r;
+                m_path[0] = {l, r + 1, unknown, unknown};
+                m_depth = 1;
+            } else {
+                //Nodes whose path is a prefix of x
+                uint64_t depth = 0;
+                while (depth + 1 < m_depth && bit(m_value, depth, levels) == bit(x, depth, levels)) ++depth;
+                m_depth = depth + 1;
+            }
+
+            uint64_t k = m_depth - 1;
+            bool tight = true; //the path is a prefix of x
+            while (k < levels) {
+                node_type &v = m_path[k];
+                if (v.ones_b == unknown) {
+                    uint64_t start = k * n;
+                    v.ones_b = tree_rank(start + v.b) - rank_level[k];
+                    v.ones_e = tree_rank(start + v.e) - rank_level[k];
+                }
+                uint64_t ones = v.ones_e - v.ones_b;
+                uint64_t zeros = (v.e - v.b) - ones;
+                node_type left = {v.b - v.ones_b, v.e - v.ones_e, unknown, unknown};
+                node_type right = {zero_cnt[k] + v.ones_b, zero_cnt[k] + v.ones_e, unknown, unknown};
+
+                if (!tight || bit(x, k, levels) == 0) {
+                    if (zeros > 0) {
+                        m_path[m_depth++] = left;
+                        set_bit(k, levels, 0);
+                        ++k;
+                        continue;
+                    }
+                    if (ones > 0) {
+                        m_path[m_depth++] = right;
+                        set_bit(k, levels, 1);
+                        tight = false;
+                        ++k;
+                        continue;
+                    }
+                } else if (ones > 0) {
+                    m_path[m_depth++] = right;
+                    set_bit(k, levels, 1);
+                    ++k;
+                    continue;
+                }
+
+                //No value >= x below v: go up until a left child taken for x has a non-empty right sibling
+                while (true) {
+                    if (k == 0) {
+                        m_depth = 1;
+                        return 0;
+                    }
+                    --m_depth;
+                    --k;
+                    node_type &u = m_path[k];
+                    if (bit(m_value, k, levels) == 0 && u.ones_e > u.ones_b) {
+                        m_path[m_depth++] = {zero_cnt[k] + u.ones_b, zero_cnt[k] + u.ones_e, unknown, unknown};
+                        set_bit(k, levels, 1);
+                        tight = false;
+                        ++k;
+                        break;
+                    }
+                }
+            }
+            return m_value;
+        }
+
+        //Wavelet trees with alphabetic codes are searched from the root
+        template<class t_bv, class t_rank, class t_select_1, class t_select_0>
+        uint64_t next_value(const wt_alphabetic<t_bv, t_rank, t_select_1, t_select_0> &wt, const uint64_t x,
+                            const uint64_t l, const uint64_t r) {
+            return wt.range_next_value(x, l, r);
+        }
+
+        //Run-length encoded sequences are searched in the wavelet matrix of the heads of the runs
+        template<class t_wm, class t_bv>
+        uint64_t next_value(const wm_rle<t_wm, t_bv> &wt, const uint64_t x, const uint64_t l, const uint64_t r) {
+            if (l > r || r >= wt.size()) return 0;
+            auto runs = wt.run_range(l, r);
+            return next_value(wt.heads(), x, runs.first, runs.second);
+        }
+
+        //The levels of wm_adaptive have different encodings and are searched from the root
+        uint64_t next_value(const wm_adaptive &wm, const uint64_t x, const uint64_t l, const uint64_t r);
+    };
+}
+
+#endif //RING_WM_CURSOR_HPP
@@ -0,0 +1,169 @@
+/*
+ * wm_rank.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RING_WM_RANK_HPP
+#define RING_WM_RANK_HPP
+
+#include <cstdint>
+#include <utility>
+#include "configuration.hpp"
+#include "index_format.hpp"
+
+namespace ring {
+
+    /**
+     * Computes rank(i, c) and rank(j, c) of a wavelet matrix in a single descent. Both positions follow
+     * the same node at each level, so the rank at the beginning of the node is shared and the two ranks
+     * of the level are close in memory; wm_int::rank twice needs 4 ranks per level, this one 3.
+     *
+     * @param wm    Wavelet matrix
+     * @param i     First position (i <= j)
+     * @param j     Second position
+     * @param c     Value
+     * @return      The pair (rank(i, c), rank(j, c))
+     */
+    template<class t_wm>
+    std::pair<uint64_t, uint64_t> wm_rank_pair(const t_wm &wm, uint64_t i, uint64_t j, const uint64_t c) {
+        typedef index_format::wm_members<t_wm> members;
+        const uint64_t levels = wm.*members::max_level();
+        const uint64_t n = wm.*members::size();
+        const auto &tree_rank = wm.*members::tree_rank();
+        const auto &zero_cnt = wm.*members::zero_cnt();
+        const auto &rank_level = wm.*members::rank_level();
+
+        if (levels < 64 && (c >> levels) != 0) return {0, 0};
+        if (levels == 0) return {i, j}; //empty or all zeros: every value is 0
+        uint64_t mask = 1ULL << (levels - 1);
+        uint64_t b = 0; //beginning of the node in m_tree
+        for (uint64_t k = 0; k < levels && j; ++k) {
+            uint64_t rank_b = tree_rank(b);
+            uint64_t ones_i = tree_rank(b + i) - rank_b;
+            uint64_t ones_j = tree_rank(b + j) - rank_b;
+            uint64_t ones_p = rank_b - rank_level[k];
+            if (c & mask) {
+                i = ones_i;
+                j = ones_j;
+                b = (k + 1) * n + zero_cnt[k] + ones_p;
+            } else {
+                i = i - ones_i;
+                j = j - ones_j;
+                b = (k + 1) * n + (b - k * n - ones_p);
+            }
+            mask >>= 1;
+        }
+        return {i, j};
+    }
+
+    /**
+     * Same as wm_int::select, with the path of the descent kept on the stack.
+     *
+     * @param wm    Wavelet matrix
+     * @param i     Occurrence, i >= 1
+     * @param c     Value
+     * @return      Position of the i-th occurrence of c
+     */
+    template<class t_wm>
+    uint64_t wm_select_stack(const t_wm &wm, uint64_t i, const uint64_t c) {
+        typedef index_format::wm_members<t_wm> members;
+        const uint64_t levels = wm.*members::max_level();
+        const uint64_t n = wm.*members::size();
+        const auto &tree_rank = wm.*members::tree_rank();
+        const auto &tree_select1 = wm.*members::tree_select1();
+        const auto &tree_select0 = wm.*members::tree_select0();
+        const auto &zero_cnt = wm.*members::zero_cnt();
+        const auto &rank_level = wm.*members::rank_level();
+
+        if (levels < 64 && (c >> levels) != 0) return n;
+        if (levels == 0) return i - 1; //empty or all zeros: every value is 0
+        uint64_t path_off[64];      //beginning of the node of each level in m_tree
+        uint64_t path_rank_off[64]; //ones before it
+        uint64_t mask = 1ULL << (levels - 1);
+        uint64_t b = 0;
+        for (uint64_t k = 0; k < levels; ++k) {
+            uint64_t rank_b = tree_rank(b);
+            uint64_t ones_p = rank_b - rank_level[k];
+            path_off[k] = b;
+            path_rank_off[k] = rank_b;
+            if (c & mask) {
+                b = (k + 1) * n + zero_cnt[k] + ones_p;
+            } else {
+                b = (k + 1) * n + (b - k * n - ones_p);
+            }
+            mask >>= 1;
+        }
+        mask = 1ULL;
+        for (uint64_t k = levels; k-- > 0;) {
+            b = path_off[k];
+            uint64_t rank_b = path_rank_off[k];
+            if (c & mask) {
+                i = tree_select1(rank_b + i) - b + 1;
+            } else {
+                i = tree_select0(b - rank_b + i) - b + 1;
+            }
+            mask <<= 1;
+        }
+        return i - 1;
+    }
+
+    /**
+     * Same as the select_next of the wavelet matrices, through wm_select_stack.
+     *
+     * @param wm        Wavelet matrix
+     * @param pos       Position
+     * @param val       Value
+     * @param n_elems   Occurrences of val
+     * @return          {position of the first occurrence of val at or after pos, its rank}, or {0, 0}
+     */
+    template<class t_wm>
+    std::pair<uint64_t, uint64_t> wm_select_next_stack(const t_wm &wm, const uint64_t pos, const uint64_t val,
+                                                       const uint64_t n_elems) {
+        uint64_t r = wm.rank(pos, val);
+        if (r >= n_elems) return {0, 0};
+        return {wm_select_stack(wm, r + 1, val), r};
+    }
+
+    /**
+     * Select of a wavelet matrix. wm_int::select keeps the path of its descent in mutable members of the
+     * wavelet matrix, so two threads that select on the same matrix overwrite each other's path. With
+     * concurrent the path is kept on the stack (wm_select_stack) instead; the ring passes the setting given
+     * with ring::set_concurrent_select. check-select compares wm_select_stack with the select of the
+     * installed sdsl.
+     *
+     * @param wm            Wavelet matrix
+     * @param i             Occurrence, i >= 1
+     * @param c             Value
+     * @param concurrent    True if other threads may select on wm at the same time
+     * @return              Position of the i-th occurrence of c
+     */
+    template<class t_wm>
+    inline uint64_t wm_select(const t_wm &wm, const uint64_t i, const uint64_t c, const bool concurrent) {
+        if (concurrent) return wm_select_stack(wm, i, c);
+        return wm.select(i, c);
+    }
+
+    template<class t_wm>
+    inline std::pair<uint64_t, uint64_t> wm_select_next(const t_wm &wm, const uint64_t pos, const uint64_t val,
+                                                        const uint64_t n_elems, const bool concurrent) {
+        if (concurrent) return wm_select_next_stack(wm, pos, val, n_elems);
+        return wm.select_next(pos, val, n_elems);
+    }
+}
+
+#endif //RING_WM_RANK_HPP
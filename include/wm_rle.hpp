@@ -0,0 +1,378 @@
+/*
+ * wm_rle.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RING_WM_RLE_HPP
+#define RING_WM_RLE_HPP
+
+#include <string>
+#include <utility>
+#include <vector>
+#include "configuration.hpp"
+#include "index_format.hpp"
+#include "wm_rank.hpp"
+
+namespace ring {
+
+    /*
+     * Run-length encoded sequence with the interface of wm_int used by bwt, for BWTs with long runs of
+     * equal symbols. With r runs it stores:
+     *
+     *  runs    n bits marking the first position of each run (sparse)
+     *  heads   wavelet matrix with the symbol of each run (r symbols)
+     *  lens    n bits marking where each run starts when the runs are grouped by symbol, in their order
+     *          in the sequence, and the groups are sorted by symbol (sparse)
+     *  C       positions and runs of the symbols smaller than each symbol
+     *
+     * so it takes O(r log n) bits. Each operation is one or two operations on heads plus a few on the
+     * sparse bitvectors (the run-length FM-index of Mäkinen and Navarro).
+     */
+    template<class t_wm = sdsl::wm_int<sdsl::bit_vector, sdsl::rank_support_v<>,
+            sdsl::select_support_mcl<1>, sdsl::select_support_mcl<0>>,
+            class t_bv = sdsl::sd_vector<>>
+    class wm_rle {
+
+    public:
+        typedef uint64_t size_type;
+        typedef uint64_t value_type;
+        typedef t_wm heads_type;
+        typedef t_bv bit_vector_type;
+        typedef typename t_bv::rank_1_type rank_1_type;
+        typedef typename t_bv::select_1_type select_1_type;
+
+    private:
+        size_type m_size = 0;
+        size_type m_sigma = 0;              //largest symbol + 1
+        bit_vector_type m_runs;
+        rank_1_type m_runs_rank;
+        select_1_type m_runs_select;
+        heads_type m_heads;
+        bit_vector_type m_lens;
+        rank_1_type m_lens_rank;
+        select_1_type m_lens_select;
+        sdsl::int_vector<> m_C;             //positions with a symbol smaller than c
+        sdsl::int_vector<> m_run_C;         //runs with a symbol smaller than c
+
+        //Length of the first k runs of c
+        inline uint64_t run_length_sum(const value_type c, const uint64_t k) const {
+            if (k == m_run_C[c + 1] - m_run_C[c]) return m_C[c + 1] - m_C[c];
+            return m_lens_select(m_run_C[c] + k + 1) - m_C[c];
+        }
+
+        //Run of the position i
+        inline uint64_t run(const size_type i) const {
+            return m_runs_rank(i + 1) - 1;
+        }
+
+        void copy(const wm_rle &o) {
+            m_size = o.m_size;
+            m_sigma = o.m_sigma;
+            m_runs = o.m_runs;
+            m_runs_rank = o.m_runs_rank;
+            m_runs_rank.set_vector(&m_runs);
+            m_runs_select = o.m_runs_select;
+            m_runs_select.set_vector(&m_runs);
+            m_heads = o.m_heads;
+            m_lens = o.m_lens;
+            m_lens_rank = o.m_lens_rank;
+            m_lens_rank.set_vector(&m_lens);
+            m_lens_select = o.m_lens_select;
+            m_lens_select.set_vector(&m_lens);
+            m_C = o.m_C;
+            m_run_C = o.m_run_C;
+        }
+
+    public:
+
+        wm_rle() = default;
+
+        template<uint8_t int_width>
+        wm_rle(sdsl::int_vector_buffer<int_width> &buf, const size_type size) : m_size(size) {
+            if (m_size == 0) return;
+            //Runs and their symbols
+            sdsl::bit_vector runs(m_size, 0);
+            std::vector<uint64_t> heads, freq, run_freq;
+            for (size_type i = 0; i < m_size; ++i) {
+                uint64_t c = buf[i];
+                if (c >= freq.size()) {
+                    freq.resize(c + 1, 0);
+                    run_freq.resize(c + 1, 0);
+                }
+                ++freq[c];
+                if (i == 0 || c != heads.back()) {
+                    runs[i] = 1;
+                    heads.push_back(c);
+                    ++run_freq[c];
+                }
+            }
+            m_sigma = freq.size();
+            m_C = sdsl::int_vector<>(m_sigma + 1, 0, sdsl::bits::hi(m_size) + 1);
+            m_run_C = sdsl::int_vector<>(m_sigma + 1, 0, sdsl::bits::hi(heads.size()) + 1);
+            for (uint64_t c = 0; c < m_sigma; ++c) {
+                m_C[c + 1] = m_C[c] + freq[c];
+                m_run_C[c + 1] = m_run_C[c] + run_freq[c];
+            }
+
+            //Runs grouped by symbol
+            sdsl::bit_vector lens(m_size, 0);
+            std::vector<uint64_t> filled(m_sigma, 0);
+            for (uint64_t j = 0, start = 0; j < heads.size(); ++j) {
+                uint64_t c = heads[j];
+                uint64_t end = start + 1;
+                while (end < m_size && !runs[end]) ++end;
+                lens[m_C[c] + filled[c]] = 1;
+                filled[c] += end - start;
+                start = end;
+            }
+
+            {
+                bit_vector_type tmp(runs);
+                m_runs.swap(tmp);
+            }
+            {
+                bit_vector_type tmp(lens);
+                m_lens.swap(tmp);
+            }
+            sdsl::util::init_support(m_runs_rank, &m_runs);
+            sdsl::util::init_support(m_runs_select, &m_runs);
+            sdsl::util::init_support(m_lens_rank, &m_lens);
+            sdsl::util::init_support(m_lens_select, &m_lens);
+
+            sdsl::int_vector<> heads_iv(heads.size(), 0, sdsl::bits::hi(m_sigma) + 1);
+            for (uint64_t j = 0; j < heads.size(); ++j) heads_iv[j] = heads[j];
+            std::vector<uint64_t>().swap(heads);
+            sdsl::construct_im(m_heads, heads_iv, 0);
+        }
+
+        //! Copy constructor
+        wm_rle(const wm_rle &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        wm_rle(wm_rle &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        wm_rle &operator=(const wm_rle &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        wm_rle &operator=(wm_rle &&o) {
+            if (this != &o) {
+                m_size = o.m_size;
+                m_sigma = o.m_sigma;
+                m_runs = std::move(o.m_runs);
+                m_runs_rank = std::move(o.m_runs_rank);
+                m_runs_rank.set_vector(&m_runs);
+                m_runs_select = std::move(o.m_runs_select);
+                m_runs_select.set_vector(&m_runs);
+                m_heads = std::move(o.m_heads);
+                m_lens = std::move(o.m_lens);
+                m_lens_rank = std::move(o.m_lens_rank);
+                m_lens_rank.set_vector(&m_lens);
+                m_lens_select = std::move(o.m_lens_select);
+                m_lens_select.set_vector(&m_lens);
+                m_C = std::move(o.m_C);
+                m_run_C = std::move(o.m_run_C);
+            }
+            return *this;
+        }
+
+        void swap(wm_rle &o) {
+            std::swap(m_size, o.m_size);
+            std::swap(m_sigma, o.m_sigma);
+            m_runs.swap(o.m_runs);
+            sdsl::util::swap_support(m_runs_rank, o.m_runs_rank, &m_runs, &o.m_runs);
+            sdsl::util::swap_support(m_runs_select, o.m_runs_select, &m_runs, &o.m_runs);
+            m_heads.swap(o.m_heads);
+            m_lens.swap(o.m_lens);
+            sdsl::util::swap_support(m_lens_rank, o.m_lens_rank, &m_lens, &o.m_lens);
+            sdsl::util::swap_support(m_lens_select, o.m_lens_select, &m_lens, &o.m_lens);
+            m_C.swap(o.m_C);
+            m_run_C.swap(o.m_run_C);
+        }
+
+        inline size_type size() const {
+            return m_size;
+        }
+
+        inline bool empty() const {
+            return m_size == 0;
+        }
+
+        //Number of runs
+        inline size_type runs() const {
+            return m_heads.size();
+        }
+
+        inline const heads_type &heads() const {
+            return m_heads;
+        }
+
+        //Runs of the positions l and r
+        inline std::pair<uint64_t, uint64_t> run_range(const size_type l, const size_type r) const {
+            return {run(l), run(r)};
+        }
+
+        value_type operator[](const size_type i) const {
+            return m_heads[run(i)];
+        }
+
+        //Occurrences of c in [0, i)
+        size_type rank(const size_type i, const value_type c) const {
+            if (i == 0 || c >= m_sigma) return 0;
+            uint64_t j = run(i - 1);
+            auto h = m_heads.inverse_select(j);
+            if (h.second == c) return run_length_sum(c, h.first) + i - m_runs_select(j + 1);
+            return run_length_sum(c, m_heads.rank(j + 1, c));
+        }
+
+        //{rank(i, c), rank(j, c)}
+        std::pair<size_type, size_type> rank_pair(const size_type i, const size_type j, const value_type c) const {
+            return {rank(i, c), rank(j, c)};
+        }
+
+        //Position of the i-th occurrence of c, i >= 1 (see wm_select for concurrent)
+        size_type select(const size_type i, const value_type c, const bool concurrent = false) const {
+            if (c >= m_sigma || i > m_C[c + 1] - m_C[c]) return m_size;
+            uint64_t p = m_C[c] + i - 1;
+            uint64_t t = m_lens_rank(p + 1) - m_run_C[c]; //runs of c that start before or at p
+            uint64_t offset = p - m_lens_select(m_run_C[c] + t);
+            return m_runs_select(wm_select(m_heads, t, c, concurrent) + 1) + offset;
+        }
+
+        //{rank(i, L[i]), L[i]}
+        std::pair<size_type, value_type> inverse_select(const size_type i) const {
+            uint64_t j = run(i);
+            auto h = m_heads.inverse_select(j);
+            return {run_length_sum(h.second, h.first) + i - m_runs_select(j + 1), h.second};
+        }
+
+        //{position of the next occurrence of val after the first pos ones, its rank}, or {0, 0}
+        std::pair<size_type, size_type> select_next(size_type pos, value_type val, size_type n_elems,
+                                                    const bool concurrent = false) const {
+            size_type r = rank(pos, val);
+            if (r >= n_elems) return {0, 0};
+            return {select(r + 1, val, concurrent), r};
+        }
+
+        value_type range_minimum_query(const size_type l, const size_type r) const {
+            return m_heads.range_minimum_query(run(l), run(r));
+        }
+
+        //Smallest value >= x in [l, r], or 0 if there is none
+        value_type range_next_value(const value_type x, const size_type l, const size_type r) const {
+            if (l > r || r >= m_size) return 0;
+            return m_heads.range_next_value(x, run(l), run(r));
+        }
+
+        std::vector<value_type> all_values_in_range(const size_type l, const size_type r) const {
+            if (l > r || r >= m_size) return {};
+            return m_heads.all_values_in_range(run(l), run(r));
+        }
+
+        //Calls f(name, component) for each component, and f(name, support, bitvector) for the rank and
+        //select structures (see index_format)
+        template<class t_wt, class t_f>
+        static void sections(t_wt &wt, const std::string &prefix, t_f &f) {
+            f(prefix + "size", wt.m_size);
+            f(prefix + "sigma", wt.m_sigma);
+            f(prefix + "runs", wt.m_runs);
+            f(prefix + "runs_rank", wt.m_runs_rank, &wt.m_runs);
+            f(prefix + "runs_select", wt.m_runs_select, &wt.m_runs);
+            index_format::wm_sections(wt.m_heads, prefix + "heads.", f);
+            f(prefix + "lens", wt.m_lens);
+            f(prefix + "lens_rank", wt.m_lens_rank, &wt.m_lens);
+            f(prefix + "lens_select", wt.m_lens_select, &wt.m_lens);
+            f(prefix + "C", wt.m_C);
+            f(prefix + "run_C", wt.m_run_C);
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+            size_type written_bytes = 0;
+            written_bytes += sdsl::write_member(m_size, out, child, "size");
+            written_bytes += sdsl::write_member(m_sigma, out, child, "sigma");
+            written_bytes += m_runs.serialize(out, child, "runs");
+            written_bytes += m_runs_rank.serialize(out, child, "runs_rank");
+            written_bytes += m_runs_select.serialize(out, child, "runs_select");
+            written_bytes += m_heads.serialize(out, child, "heads");
+            written_bytes += m_lens.serialize(out, child, "lens");
+            written_bytes += m_lens_rank.serialize(out, child, "lens_rank");
+            written_bytes += m_lens_select.serialize(out, child, "lens_select");
+            written_bytes += m_C.serialize(out, child, "C");
+            written_bytes += m_run_C.serialize(out, child, "run_C");
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream &in) {
+            sdsl::read_member(m_size, in);
+            sdsl::read_member(m_sigma, in);
+            m_runs.load(in);
+            m_runs_rank.load(in, &m_runs);
+            m_runs_select.load(in, &m_runs);
+            m_heads.load(in);
+            m_lens.load(in);
+            m_lens_rank.load(in, &m_lens);
+            m_lens_select.load(in, &m_lens);
+            m_C.load(in);
+            m_run_C.load(in);
+        }
+    };
+
+    template<class t_wm, class t_bv>
+    std::pair<uint64_t, uint64_t> wm_rank_pair(const wm_rle<t_wm, t_bv> &wt, const uint64_t i, const uint64_t j,
+                                               const uint64_t c) {
+        return wt.rank_pair(i, j, c);
+    }
+
+    template<class t_wm, class t_bv>
+    uint64_t wm_select(const wm_rle<t_wm, t_bv> &wt, const uint64_t i, const uint64_t c, const bool concurrent) {
+        return wt.select(i, c, concurrent);
+    }
+
+    template<class t_wm, class t_bv>
+    std::pair<uint64_t, uint64_t> wm_select_next(const wm_rle<t_wm, t_bv> &wt, const uint64_t pos, const uint64_t val,
+                                                 const uint64_t n_elems, const bool concurrent) {
+        return wt.select_next(pos, val, n_elems, concurrent);
+    }
+
+    namespace index_format {
+
+        template<class t_wm, class t_bv, class t_f>
+        void wm_sections(wm_rle<t_wm, t_bv> &wt, const std::string &prefix, t_f &f) {
+            wm_rle<t_wm, t_bv>::sections(wt, prefix, f);
+        }
+
+        template<class t_wm, class t_bv, class t_f>
+        void wm_sections(const wm_rle<t_wm, t_bv> &wt, const std::string &prefix, t_f &f) {
+            wm_rle<t_wm, t_bv>::sections(wt, prefix, f);
+        }
+    }
+}
+
+#endif //RING_WM_RLE_HPP
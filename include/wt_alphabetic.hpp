@@ -0,0 +1,514 @@
+/*
+ * wt_alphabetic.hpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef RING_WT_ALPHABETIC_HPP
+#define RING_WT_ALPHABETIC_HPP
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "configuration.hpp"
+
+namespace ring {
+
+    /*
+     * Wavelet tree shaped by the frequencies of the symbols, with the interface of wm_int used by bwt.
+     * The codes are alphabetic (they keep the order of the symbols, so range_next_value and
+     * all_values_in_range work as in a balanced wavelet matrix) and are built by splitting each range of
+     * symbols where its weight is best balanced, which gives codes within two bits of the entropy of
+     * the symbol. Frequent symbols have short codes: fewer levels to walk, and fewer bits to store.
+     *
+     * The bits of the internal nodes are concatenated in a single bitvector; each node stores where its
+     * bits begin and the number of ones before them. Symbols that do not occur have no leaf.
+     */
+    template<class t_bv = sdsl::bit_vector,
+            class t_rank = typename t_bv::rank_1_type,
+            class t_select_1 = typename t_bv::select_1_type,
+            class t_select_0 = typename t_bv::select_0_type>
+    class wt_alphabetic {
+
+    public:
+        typedef uint64_t size_type;
+        typedef uint64_t value_type;
+        typedef t_bv bit_vector_type;
+        typedef t_rank rank_1_type;
+        typedef t_select_1 select_1_type;
+        typedef t_select_0 select_0_type;
+
+        static const uint64_t max_code_length = 64;
+
+    private:
+        static const uint64_t not_found = (uint64_t) -1;
+
+        size_type m_size = 0;
+        size_type m_sigma = 0;              //largest symbol + 1
+        bit_vector_type m_tree;
+        rank_1_type m_tree_rank;
+        select_1_type m_tree_select1;
+        select_0_type m_tree_select0;
+        uint64_t m_root = 0;                //the root as an entry of m_child
+        sdsl::int_vector<> m_node_offset;   //beginning of the bits of each internal node in m_tree
+        sdsl::int_vector<> m_node_rank;     //ones in m_tree before them
+        sdsl::int_vector<> m_child;         //m_child[2v+b]: (w << 1) for the internal node w, (c << 1) | 1 for the leaf of c
+        sdsl::int_vector<> m_code;          //code of each symbol, its first bit is the one of the root
+        sdsl::int_vector<> m_code_length;
+        sdsl::int_vector<> m_succ;          //smallest symbol >= c that occurs, m_sigma if there is none
+
+        typedef struct {
+            std::vector<uint64_t> child;
+            std::vector<uint64_t> size;
+            std::vector<uint64_t> code;
+            std::vector<uint64_t> code_length;
+        } shape_type;
+
+        static inline bool is_leaf(const uint64_t x) {
+            return x & 1ULL;
+        }
+
+        inline uint64_t bit(const uint64_t c, const uint64_t d) const {
+            return (m_code[c] >> (m_code_length[c] - 1 - d)) & 1ULL;
+        }
+
+        //Ones among the first i bits of the internal node v
+        inline uint64_t ones(const uint64_t v, const uint64_t i) const {
+            return m_tree_rank(m_node_offset[v] + i) - m_node_rank[v];
+        }
+
+        inline bool occurs(const uint64_t c) const {
+            return c < m_sigma && m_succ[c] == c;
+        }
+
+        /**
+         * Builds the subtree of the symbols[a..b] and returns it as an entry of child. The nodes are
+         * numbered in preorder.
+         *
+         * @param weights   weights[k] is the number of occurrences of symbols[0..k-1]
+         */
+        static uint64_t build_shape(const std::vector<uint64_t> &symbols, const std::vector<uint64_t> &weights,
+                                    const uint64_t a, const uint64_t b, const uint64_t code,
+                                    const uint64_t depth, shape_type &shape) {
+            if (a == b) {
+                shape.code[symbols[a]] = code;
+                shape.code_length[symbols[a]] = depth;
+                return (symbols[a] << 1) | 1ULL;
+            }
+            if (depth == max_code_length) throw std::runtime_error("Code too long in wt_alphabetic");
+            //Last symbol of the left child: the split closest to half of the weight
+            uint64_t half = weights[a] + (weights[b + 1] - weights[a]) / 2;
+            uint64_t k = std::lower_bound(weights.begin() + a + 1, weights.begin() + b + 1, half) - weights.begin();
+            if (k > a + 1 && half - weights[k - 1] < weights[k] - half) --k;
+            k = std::min(std::max(k, a + 1), b) - 1;
+
+            uint64_t v = shape.size.size();
+            shape.size.push_back(weights[b + 1] - weights[a]);
+            shape.child.resize(2 * shape.size.size());
+            uint64_t left = build_shape(symbols, weights, a, k, code << 1, depth + 1, shape);
+            uint64_t right = build_shape(symbols, weights, k + 1, b, (code << 1) | 1ULL, depth + 1, shape);
+            shape.child[2 * v] = left;
+            shape.child[2 * v + 1] = right;
+            return v << 1;
+        }
+
+        //Smallest symbol >= y below the entry x, whose positions are [b, e) (not_found if there is none)
+        uint64_t next_value(const uint64_t x, const uint64_t b, const uint64_t e, const uint64_t y,
+                            const uint64_t d, const bool tight) const {
+            if (is_leaf(x)) return x >> 1;
+            uint64_t v = x >> 1;
+            uint64_t ones_b = ones(v, b), ones_e = ones(v, e);
+            bool has_ones = ones_e > ones_b;
+            bool has_zeros = (e - b) > (ones_e - ones_b);
+            if (!tight || bit(y, d) == 0) {
+                if (has_zeros) {
+                    uint64_t res = next_value(m_child[2 * v], b - ones_b, e - ones_e, y, d + 1, tight);
+                    if (res != not_found) return res;
+                }
+                if (has_ones) return next_value(m_child[2 * v + 1], ones_b, ones_e, y, d + 1, false);
+                return not_found;
+            }
+            if (has_ones) return next_value(m_child[2 * v + 1], ones_b, ones_e, y, d + 1, true);
+            return not_found;
+        }
+
+        void values(const uint64_t x, const uint64_t b, const uint64_t e, std::vector<value_type> &res) const {
+            if (is_leaf(x)) {
+                res.push_back(x >> 1);
+                return;
+            }
+            uint64_t v = x >> 1;
+            uint64_t ones_b = ones(v, b), ones_e = ones(v, e);
+            if ((e - b) > (ones_e - ones_b)) values(m_child[2 * v], b - ones_b, e - ones_e, res);
+            if (ones_e > ones_b) values(m_child[2 * v + 1], ones_b, ones_e, res);
+        }
+
+        void copy(const wt_alphabetic &o) {
+            m_size = o.m_size;
+            m_sigma = o.m_sigma;
+            m_tree = o.m_tree;
+            m_tree_rank = o.m_tree_rank;
+            m_tree_rank.set_vector(&m_tree);
+            m_tree_select1 = o.m_tree_select1;
+            m_tree_select1.set_vector(&m_tree);
+            m_tree_select0 = o.m_tree_select0;
+            m_tree_select0.set_vector(&m_tree);
+            m_root = o.m_root;
+            m_node_offset = o.m_node_offset;
+            m_node_rank = o.m_node_rank;
+            m_child = o.m_child;
+            m_code = o.m_code;
+            m_code_length = o.m_code_length;
+            m_succ = o.m_succ;
+        }
+
+    public:
+
+        wt_alphabetic() = default;
+
+        template<uint8_t int_width>
+        wt_alphabetic(sdsl::int_vector_buffer<int_width> &buf, const size_type size) : m_size(size) {
+            if (m_size == 0) return;
+            //Frequencies
+            std::vector<uint64_t> freq;
+            for (size_type i = 0; i < m_size; ++i) {
+                uint64_t c = buf[i];
+                if (c >= freq.size()) freq.resize(c + 1, 0);
+                ++freq[c];
+            }
+            m_sigma = freq.size();
+            std::vector<uint64_t> symbols, weights(1, 0);
+            m_succ = sdsl::int_vector<>(m_sigma, m_sigma, sdsl::bits::hi(m_sigma) + 1);
+            for (uint64_t c = 0; c < m_sigma; ++c) {
+                if (freq[c] == 0) continue;
+                symbols.push_back(c);
+                weights.push_back(weights.back() + freq[c]);
+            }
+            for (uint64_t c = m_sigma, k = symbols.size(); c-- > 0;) {
+                if (k > 0 && symbols[k - 1] == c) --k;
+                if (k < symbols.size()) m_succ[c] = symbols[k];
+            }
+
+            //Shape and codes
+            shape_type shape;
+            shape.code.assign(m_sigma, 0);
+            shape.code_length.assign(m_sigma, 0);
+            m_root = build_shape(symbols, weights, 0, symbols.size() - 1, 0, 0, shape);
+            uint64_t n_nodes = shape.size.size();
+            uint64_t max_length = 0;
+            for (uint64_t c : symbols) max_length = std::max(max_length, shape.code_length[c]);
+            m_code = sdsl::int_vector<>(m_sigma, 0, std::max<uint64_t>(max_length, 1));
+            m_code_length = sdsl::int_vector<>(m_sigma, 0, sdsl::bits::hi(max_code_length) + 1);
+            for (uint64_t c : symbols) {
+                m_code[c] = shape.code[c];
+                m_code_length[c] = shape.code_length[c];
+            }
+            m_child = sdsl::int_vector<>(2 * n_nodes, 0, sdsl::bits::hi(std::max<uint64_t>(2 * m_sigma, 2 * n_nodes)) + 1);
+            for (uint64_t k = 0; k < 2 * n_nodes; ++k) m_child[k] = shape.child[k];
+
+            //Bits of the nodes
+            uint64_t n_bits = 0;
+            std::vector<uint64_t> offset(n_nodes);
+            for (uint64_t v = 0; v < n_nodes; ++v) {
+                offset[v] = n_bits;
+                n_bits += shape.size[v];
+            }
+            sdsl::bit_vector tree(n_bits, 0);
+            for (size_type i = 0; i < m_size; ++i) {
+                uint64_t c = buf[i];
+                uint64_t x = m_root;
+                for (uint64_t d = 0; !is_leaf(x); ++d) {
+                    uint64_t v = x >> 1;
+                    uint64_t b = bit(c, d);
+                    tree[offset[v]++] = b;
+                    x = m_child[2 * v + b];
+                }
+            }
+            {
+                bit_vector_type tmp(tree);
+                m_tree.swap(tmp);
+            }
+            sdsl::util::init_support(m_tree_rank, &m_tree);
+            sdsl::util::init_support(m_tree_select1, &m_tree);
+            sdsl::util::init_support(m_tree_select0, &m_tree);
+
+            uint8_t width = sdsl::bits::hi(std::max<uint64_t>(n_bits, 1)) + 1;
+            m_node_offset = sdsl::int_vector<>(n_nodes, 0, width);
+            m_node_rank = sdsl::int_vector<>(n_nodes, 0, width);
+            for (uint64_t v = 0; v < n_nodes; ++v) {
+                m_node_offset[v] = offset[v] - shape.size[v];
+                m_node_rank[v] = m_tree_rank(m_node_offset[v]);
+            }
+        }
+
+        //! Copy constructor
+        wt_alphabetic(const wt_alphabetic &o) {
+            copy(o);
+        }
+
+        //! Move constructor
+        wt_alphabetic(wt_alphabetic &&o) {
+            *this = std::move(o);
+        }
+
+        //! Copy Operator=
+        wt_alphabetic &operator=(const wt_alphabetic &o) {
+            if (this != &o) {
+                copy(o);
+            }
+            return *this;
+        }
+
+        //! Move Operator=
+        wt_alphabetic &operator=(wt_alphabetic &&o) {
+            if (this != &o) {
+                m_size = o.m_size;
+                m_sigma = o.m_sigma;
+                m_tree = std::move(o.m_tree);
+                m_tree_rank = std::move(o.m_tree_rank);
+                m_tree_rank.set_vector(&m_tree);
+                m_tree_select1 = std::move(o.m_tree_select1);
+                m_tree_select1.set_vector(&m_tree);
+                m_tree_select0 = std::move(o.m_tree_select0);
+                m_tree_select0.set_vector(&m_tree);
+                m_root = o.m_root;
+                m_node_offset = std::move(o.m_node_offset);
+                m_node_rank = std::move(o.m_node_rank);
+                m_child = std::move(o.m_child);
+                m_code = std::move(o.m_code);
+                m_code_length = std::move(o.m_code_length);
+                m_succ = std::move(o.m_succ);
+            }
+            return *this;
+        }
+
+        void swap(wt_alphabetic &o) {
+            std::swap(m_size, o.m_size);
+            std::swap(m_sigma, o.m_sigma);
+            m_tree.swap(o.m_tree);
+            sdsl::util::swap_support(m_tree_rank, o.m_tree_rank, &m_tree, &o.m_tree);
+            sdsl::util::swap_support(m_tree_select1, o.m_tree_select1, &m_tree, &o.m_tree);
+            sdsl::util::swap_support(m_tree_select0, o.m_tree_select0, &m_tree, &o.m_tree);
+            std::swap(m_root, o.m_root);
+            m_node_offset.swap(o.m_node_offset);
+            m_node_rank.swap(o.m_node_rank);
+            m_child.swap(o.m_child);
+            m_code.swap(o.m_code);
+            m_code_length.swap(o.m_code_length);
+            m_succ.swap(o.m_succ);
+        }
+
+        inline size_type size() const {
+            return m_size;
+        }
+
+        inline bool empty() const {
+            return m_size == 0;
+        }
+
+        //Length of the code of c, 0 if c does not occur (or if it is the only symbol)
+        inline uint64_t code_length(const value_type c) const {
+            return occurs(c) ? m_code_length[c] : 0;
+        }
+
+        value_type operator[](size_type i) const {
+            return inverse_select(i).second;
+        }
+
+        //Occurrences of c in [0, i)
+        size_type rank(size_type i, const value_type c) const {
+            if (!occurs(c)) return 0;
+            uint64_t x = m_root;
+            for (uint64_t d = 0; !is_leaf(x) && i; ++d) {
+                uint64_t v = x >> 1;
+                uint64_t b = bit(c, d);
+                uint64_t o = ones(v, i);
+                i = b ? o : i - o;
+                x = m_child[2 * v + b];
+            }
+            return i;
+        }
+
+        //{rank(i, c), rank(j, c)} with one descent, i <= j
+        std::pair<size_type, size_type> rank_pair(size_type i, size_type j, const value_type c) const {
+            if (!occurs(c)) return {0, 0};
+            uint64_t x = m_root;
+            for (uint64_t d = 0; !is_leaf(x) && j; ++d) {
+                uint64_t v = x >> 1;
+                uint64_t b = bit(c, d);
+                uint64_t o_i = ones(v, i), o_j = ones(v, j);
+                i = b ? o_i : i - o_i;
+                j = b ? o_j : j - o_j;
+                x = m_child[2 * v + b];
+            }
+            return {i, j};
+        }
+
+        //Position of the i-th occurrence of c, i >= 1
+        size_type select(size_type i, const value_type c) const {
+            if (!occurs(c)) return m_size;
+            uint64_t path[max_code_length];
+            uint64_t length = 0;
+            for (uint64_t x = m_root; !is_leaf(x); ++length) {
+                path[length] = x >> 1;
+                x = m_child[2 * path[length] + bit(c, length)];
+            }
+            while (length-- > 0) {
+                uint64_t v = path[length];
+                uint64_t o = m_node_offset[v];
+                uint64_t r = m_node_rank[v];
+                uint64_t p = bit(c, length) ? m_tree_select1(r + i) : m_tree_select0(o - r + i);
+                i = p - o + 1;
+            }
+            return i - 1;
+        }
+
+        //{rank(i, L[i]), L[i]}
+        std::pair<size_type, value_type> inverse_select(size_type i) const {
+            uint64_t x = m_root;
+            while (!is_leaf(x)) {
+                uint64_t v = x >> 1;
+                uint64_t b = m_tree[m_node_offset[v] + i];
+                uint64_t o = ones(v, i);
+                i = b ? o : i - o;
+                x = m_child[2 * v + b];
+            }
+            return {i, x >> 1};
+        }
+
+        //{position of the next occurrence of val after the first pos ones, its rank}, or {0, 0}
+        std::pair<size_type, size_type> select_next(size_type pos, value_type val, size_type n_elems) const {
+            size_type r = rank(pos, val);
+            if (r >= n_elems) return {0, 0};
+            return {select(r + 1, val), r};
+        }
+
+        value_type range_minimum_query(size_type l, size_type r) const {
+            return range_next_value(0, l, r);
+        }
+
+        //Smallest value >= x in [l, r], or 0 if there is none
+        value_type range_next_value(value_type x, size_type l, size_type r) const {
+            if (l > r || r >= m_size || x >= m_sigma) return 0;
+            uint64_t y = m_succ[x];
+            if (y == m_sigma) return 0;
+            uint64_t res = next_value(m_root, l, r + 1, y, 0, true);
+            return res == not_found ? 0 : res;
+        }
+
+        //Distinct values in [l, r], in increasing order
+        std::vector<value_type> all_values_in_range(size_type l, size_type r) const {
+            std::vector<value_type> res;
+            if (l <= r && r < m_size) values(m_root, l, r + 1, res);
+            return res;
+        }
+
+        //Calls f(name, component) for each component, and f(name, support, bitvector) for the rank and
+        //select structures (see index_format)
+        template<class t_wt, class t_f>
+        static void sections(t_wt &wt, const std::string &prefix, t_f &f) {
+            f(prefix + "size", wt.m_size);
+            f(prefix + "sigma", wt.m_sigma);
+            f(prefix + "tree", wt.m_tree);
+            f(prefix + "tree_rank", wt.m_tree_rank, &wt.m_tree);
+            f(prefix + "tree_select1", wt.m_tree_select1, &wt.m_tree);
+            f(prefix + "tree_select0", wt.m_tree_select0, &wt.m_tree);
+            f(prefix + "root", wt.m_root);
+            f(prefix + "node_offset", wt.m_node_offset);
+            f(prefix + "node_rank", wt.m_node_rank);
+            f(prefix + "child", wt.m_child);
+            f(prefix + "code", wt.m_code);
+            f(prefix + "code_length", wt.m_code_length);
+            f(prefix + "succ", wt.m_succ);
+        }
+
+        //! Serializes the data structure into the given ostream
+        size_type serialize(std::ostream &out, sdsl::structure_tree_node *v = nullptr, std::string name = "") const {
+            sdsl::structure_tree_node *child = sdsl::structure_tree::add_child(v, name, sdsl::util::class_name(*this));
+            size_type written_bytes = 0;
+            written_bytes += sdsl::write_member(m_size, out, child, "size");
+            written_bytes += sdsl::write_member(m_sigma, out, child, "sigma");
+            written_bytes += m_tree.serialize(out, child, "tree");
+            written_bytes += m_tree_rank.serialize(out, child, "tree_rank");
+            written_bytes += m_tree_select1.serialize(out, child, "tree_select1");
+            written_bytes += m_tree_select0.serialize(out, child, "tree_select0");
+            written_bytes += sdsl::write_member(m_root, out, child, "root");
+            written_bytes += m_node_offset.serialize(out, child, "node_offset");
+            written_bytes += m_node_rank.serialize(out, child, "node_rank");
+            written_bytes += m_child.serialize(out, child, "child");
+            written_bytes += m_code.serialize(out, child, "code");
+            written_bytes += m_code_length.serialize(out, child, "code_length");
+            written_bytes += m_succ.serialize(out, child, "succ");
+            sdsl::structure_tree::add_size(child, written_bytes);
+            return written_bytes;
+        }
+
+        void load(std::istream &in) {
+            sdsl::read_member(m_size, in);
+            sdsl::read_member(m_sigma, in);
+            m_tree.load(in);
+            m_tree_rank.load(in, &m_tree);
+            m_tree_select1.load(in, &m_tree);
+            m_tree_select0.load(in, &m_tree);
+            sdsl::read_member(m_root, in);
+            m_node_offset.load(in);
+            m_node_rank.load(in);
+            m_child.load(in);
+            m_code.load(in);
+            m_code_length.load(in);
+            m_succ.load(in);
+        }
+    };
+
+    template<class t_bv, class t_rank, class t_select_1, class t_select_0>
+    std::pair<uint64_t, uint64_t> wm_rank_pair(const wt_alphabetic<t_bv, t_rank, t_select_1, t_select_0> &wt,
+                                               const uint64_t i, const uint64_t j, const uint64_t c) {
+        return wt.rank_pair(i, j, c);
+    }
+
+    //The path of the select of wt_alphabetic is already on the stack
+    template<class t_bv, class t_rank, class t_select_1, class t_select_0>
+    uint64_t wm_select(const wt_alphabetic<t_bv, t_rank, t_select_1, t_select_0> &wt, const uint64_t i,
+                       const uint64_t c, const bool) {
+        return wt.select(i, c);
+    }
+
+    template<class t_bv, class t_rank, class t_select_1, class t_select_0>
+    std::pair<uint64_t, uint64_t> wm_select_next(const wt_alphabetic<t_bv, t_rank, t_select_1, t_select_0> &wt,
+                                                 const uint64_t pos, const uint64_t val, const uint64_t n_elems,
+                                                 const bool) {
+        return wt.select_next(pos, val, n_elems);
+    }
+
+    namespace index_format {
+
+        template<class t_bv, class t_rank, class t_select_1, class t_select_0, class t_f>
+        void wm_sections(wt_alphabetic<t_bv, t_rank, t_select_1, t_select_0> &wt, const std::string &prefix, t_f &f) {
+            wt_alphabetic<t_bv, t_rank, t_select_1, t_select_0>::sections(wt, prefix, f);
+        }
+
+        template<class t_bv, class t_rank, class t_select_1, class t_select_0, class t_f>
+        void wm_sections(const wt_alphabetic<t_bv, t_rank, t_select_1, t_select_0> &wt, const std::string &prefix,
+                         t_f &f) {
+            wt_alphabetic<t_bv, t_rank, t_select_1, t_select_0>::sections(wt, prefix, f);
+        }
+    }
+}
+
+#endif //RING_WT_ALPHABETIC_HPP
@@ -23,6 +23,7 @@
 #include <fstream>
 #include <sdsl/construct.hpp>
 #include <ltj_algorithm.hpp>
+#include <triple_io.hpp>
 
 using namespace std;
 
@@ -30,56 +31,156 @@ using namespace std::chrono;
 using timer = std::chrono::high_resolution_clock;
 
 template<class ring>
-void build_index(const std::string &dataset, const std::string &output){
-    vector<spo_triple> D, E;
+bool build_index(const std::string &dataset, const std::string &output, const uint64_t n_threads){
+    vector<spo_triple> D;
 
-    std::ifstream ifs(dataset);
-    uint64_t s, p , o;
-    do {
-        ifs >> s >> p >> o;
-        D.push_back(spo_triple(s, p, o));
-    } while (!ifs.eof());
-
-    D.shrink_to_fit();
+    try{
+        ::ring::read_triples(dataset, D, n_threads);
+    }catch(const std::runtime_error &e){
+        cerr << "Error: " << e.what() << endl;
+        return false;
+    }
+    if(D.empty()){
+        cerr << "Error: the dataset " << dataset << " has no triples" << endl;
+        return false;
+    }
     cout << "--Indexing " << D.size() << " triples" << endl;
     memory_monitor::start();
     auto start = timer::now();
 
-    ring A(D);
+    ring A(D, n_threads);
+    auto stop = timer::now();
+    memory_monitor::stop();
+    cout << "  Index built  " << sdsl::size_in_bytes(A) << " bytes" << endl;
+    A.print_stats(cout);
+
+    sdsl::store_to_file(A, output);
+    cout << "Index saved" << endl;
+    cout << duration_cast<seconds>(stop-start).count() << " seconds." << endl;
+    cout << memory_monitor::peak() << " bytes." << endl;
+    return true;
+}
+
+// Fails, without saving the index, when the construction does not fit in the memory budget: either a
+// wavelet matrix would not fit (checked before it is built) or the peak resident memory exceeded it
+template<class ring>
+bool build_index_external(const std::string &dataset, const std::string &output, const ::ring::external::config &cfg){
+    cout << "--Indexing with a memory budget of " << cfg.memory_budget << " bytes" << endl;
+    memory_monitor::start();
+    auto start = timer::now();
+
+    ring A;
+    try{
+        A = ring(dataset, cfg);
+    }catch(const std::runtime_error &e){
+        cerr << "Error: " << e.what() << endl;
+        return false;
+    }
     auto stop = timer::now();
     memory_monitor::stop();
+    uint64_t peak = ::ring::external::peak_memory();
     cout << "  Index built  " << sdsl::size_in_bytes(A) << " bytes" << endl;
+    cout << "  Peak memory " << peak << " bytes of a budget of " << cfg.memory_budget << " bytes" << endl;
+    if(peak > cfg.memory_budget){
+        cerr << "Error: the construction exceeded the memory budget by " << peak - cfg.memory_budget
+             << " bytes. The index is not saved" << endl;
+        return false;
+    }
+    A.print_stats(cout);
 
     sdsl::store_to_file(A, output);
     cout << "Index saved" << endl;
     cout << duration_cast<seconds>(stop-start).count() << " seconds." << endl;
     cout << memory_monitor::peak() << " bytes." << endl;
+    return true;
+}
+
+template<class ring>
+bool build(const std::string &dataset, const std::string &output, const uint64_t n_threads,
+           const bool external, const ::ring::external::config &cfg){
+    if(external){
+        return build_index_external<ring>(dataset, output, cfg);
+    }
+    return build_index<ring>(dataset, output, n_threads);
+}
 
+void print_usage(const char *name){
+    std::cout << "Usage: " << name << " <dataset> [ring|c-ring|ring-sel|ring-cl|ring-alpha|r-ring|ring-adaptive] [--threads <n>]"
+              << " [--memory <MB> [--tmp-dir <dir>]] [--select-sample <n>]" << std::endl;
 }
 
 int main(int argc, char **argv)
 {
 
-    if(argc != 3){
-        std::cout << "Usage: " << argv[0] << " <dataset> [ring|c-ring|ring-sel]" << std::endl;
+    if(argc < 3){
+        print_usage(argv[0]);
         return 0;
     }
 
     std::string dataset = argv[1];
     std::string type    = argv[2];
+    uint64_t n_threads = 1;
+    bool external = false;
+    uint64_t select_sample = 0;
+    ring::external::config cfg;
+    auto p = dataset.find_last_of('/');
+    cfg.tmp_dir = (p == std::string::npos) ? "." : dataset.substr(0, p);
+    for(int i = 3; i < argc; ++i){
+        std::string option = argv[i];
+        if(option == "--threads" && i+1 < argc){
+            n_threads = std::stoull(argv[++i]);
+        }else if(option == "--memory" && i+1 < argc){
+            external = true;
+            cfg.memory_budget = std::stoull(argv[++i]) * 1024 * 1024;
+        }else if(option == "--tmp-dir" && i+1 < argc){
+            cfg.tmp_dir = argv[++i];
+        }else if(option == "--select-sample" && i+1 < argc){
+            select_sample = std::stoull(argv[++i]);
+        }else{
+            print_usage(argv[0]);
+            return 0;
+        }
+    }
+    if(select_sample > 0 && type != "ring-sel"){
+        cerr << "Error: --select-sample only applies to ring-sel, not to " << type << endl;
+        return 1;
+    }
+
+    // Only these variants select with the kernels chosen for the CPU (see cpu_kernels.hpp)
+    if(type == "ring-cl" || (type == "ring-sel" && select_sample > 0)){
+        std::cout << "Rank/select kernels: " << ring::kernels::active().name << std::endl;
+    }
+    bool ok = true;
     if(type == "ring"){
         std::string index_name = dataset + ".ring";
-        build_index<ring::ring<>>(dataset, index_name);
+        ok = build<ring::ring<>>(dataset, index_name, n_threads, external, cfg);
     }else if (type == "c-ring"){
         std::string index_name = dataset + ".c-ring";
-        build_index<ring::c_ring>(dataset, index_name);
+        ok = build<ring::c_ring>(dataset, index_name, n_threads, external, cfg);
+    }else if (type == "ring-sel" && select_sample > 0){
+        ring::select_support_sampled<1>::default_sample_rate() = select_sample;
+        ring::select_support_sampled<0>::default_sample_rate() = select_sample;
+        std::string index_name = dataset + ".ring-sampled";
+        ok = build<ring::ring_sampled>(dataset, index_name, n_threads, external, cfg);
     }else if (type == "ring-sel"){
         std::string index_name = dataset + ".ring-sel";
-        build_index<ring::ring_sel>(dataset, index_name);
+        ok = build<ring::ring_sel>(dataset, index_name, n_threads, external, cfg);
+    }else if (type == "ring-cl"){
+        std::string index_name = dataset + ".ring-cl";
+        ok = build<ring::ring_cl>(dataset, index_name, n_threads, external, cfg);
+    }else if (type == "ring-alpha"){
+        std::string index_name = dataset + ".ring-alpha";
+        ok = build<ring::ring_alpha>(dataset, index_name, n_threads, external, cfg);
+    }else if (type == "r-ring"){
+        std::string index_name = dataset + ".r-ring";
+        ok = build<ring::r_ring>(dataset, index_name, n_threads, external, cfg);
+    }else if (type == "ring-adaptive"){
+        std::string index_name = dataset + ".ring-adaptive";
+        ok = build<ring::ring_adaptive>(dataset, index_name, n_threads, external, cfg);
     }else{
-        std::cout << "Usage: " << argv[0] << " <dataset> [ring|c-ring|ring-sel]" << std::endl;
+        print_usage(argv[0]);
     }
 
-    return 0;
+    return ok ? 0 : 1;
 }
 
@@ -0,0 +1,164 @@
+/*
+ * check-prepared.cpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include "ring.hpp"
+#include <ltj_algorithm.hpp>
+#include <prepared_query.hpp>
+#include <query_parser.hpp>
+
+using namespace std;
+
+// Checks that a query with parameters ($name), run with prepared_query for a batch of bindings, returns
+// the same results as the query with the values of each binding written in place of the parameters and
+// parsed and run on its own. Each line of the bindings file holds the values of one binding, in the order
+// of the first occurrence of the parameters in the query.
+
+std::string get_type(const std::string &file){
+    std::string type = ring::index_format::read_variant(file);
+    if(!type.empty()) return type;
+    // Indexes without header: the type is given by the extension
+    auto p = file.find_last_of('.');
+    return file.substr(p+1);
+}
+
+// Results as sorted lines of name=value, so the identifiers given to the variables do not matter
+template<class tuple_type>
+std::string to_line(const tuple_type &t, const std::vector<std::string> &names){
+    std::vector<std::string> terms;
+    for(const auto &v : t) terms.push_back(names[v.first] + "=" + std::to_string(v.second));
+    std::sort(terms.begin(), terms.end());
+    std::string line;
+    for(const auto &term : terms) line += term + " ";
+    return line;
+}
+
+// The query with the values of the binding in place of the parameters
+std::string substitute(const std::string &query, const std::vector<std::string> &params,
+                       const std::vector<uint64_t> &values){
+    std::string res;
+    for(const std::string &token : ring::query_parser::tokenizer(query, '.')){
+        if(!res.empty()) res += " . ";
+        std::vector<std::string> terms = ring::query_parser::tokenizer(token, ' ');
+        for(uint64_t t = 0; t < terms.size(); ++t){
+            std::string term = terms[t];
+            auto it = std::find(params.begin(), params.end(), term);
+            if(it != params.end()){
+                term = std::to_string(values[it - params.begin()]);
+            }
+            res += (t == 0 ? "" : " ") + term;
+        }
+    }
+    return res;
+}
+
+template<class ring_type>
+bool check(const std::string &file, const std::string &query, const std::string &bindings_file){
+    ring_type graph;
+    sdsl::load_from_file(graph, file);
+
+    vector<string> lines;
+    if(!ring::query_parser::get_file_content(bindings_file, lines)) return false;
+    std::vector<std::vector<uint64_t>> bindings;
+    for(const auto &line : lines){
+        std::istringstream in(line);
+        std::vector<uint64_t> values;
+        uint64_t v;
+        while(in >> v) values.push_back(v);
+        bindings.push_back(values);
+    }
+
+    ring::prepared_query<ring_type> prepared(query, &graph);
+    std::vector<std::string> names = prepared.variable_names();
+    std::vector<std::string> params = prepared.parameter_names();
+    std::vector<std::vector<std::string>> results(bindings.size());
+    prepared.execute(bindings, [&](uint64_t i, const typename ring::prepared_query<ring_type>::tuple_type &t){
+        results[i].push_back(to_line(t, names));
+        return true;
+    });
+
+    bool ok = true;
+    for(uint64_t i = 0; i < bindings.size(); ++i){
+        std::string single = substitute(query, params, bindings[i]);
+        std::vector<ring::triple_pattern> triples;
+        std::unordered_map<std::string, uint8_t> vars;
+        ring::query_parser::get_query(single, triples, vars);
+        std::vector<std::string> single_names(vars.size());
+        for(const auto &v : vars) single_names[v.second] = v.first;
+        std::vector<std::string> expected;
+        ring::ltj_algorithm<ring_type> ltj(&triples, &graph);
+        ltj.join_stream([&](const typename ring::ltj_algorithm<ring_type>::tuple_type &t){
+            expected.push_back(to_line(t, single_names));
+            return true;
+        });
+        std::sort(expected.begin(), expected.end());
+        std::sort(results[i].begin(), results[i].end());
+        bool same = expected == results[i];
+        cout << "Binding " << i << ": " << results[i].size() << " results, " << expected.size()
+             << " expected, " << (same ? "equal" : "different") << endl;
+        ok = ok && same;
+    }
+    return ok;
+}
+
+
+int main(int argc, char* argv[])
+{
+    if(argc != 4){
+        std::cout << "Usage: " << argv[0] << " <index> <query with $parameters> <bindings>" << std::endl;
+        return 0;
+    }
+
+    std::string index = argv[1];
+    std::string query = argv[2];
+    std::string bindings = argv[3];
+    std::string type = get_type(index);
+
+    bool ok;
+    try{
+        if(type == "ring"){
+            ok = check<ring::ring<>>(index, query, bindings);
+        }else if (type == "c-ring"){
+            ok = check<ring::c_ring>(index, query, bindings);
+        }else if (type == "ring-sel"){
+            ok = check<ring::ring_sel>(index, query, bindings);
+        }else if (type == "ring-cl"){
+            ok = check<ring::ring_cl>(index, query, bindings);
+        }else if (type == "ring-sampled"){
+            ok = check<ring::ring_sampled>(index, query, bindings);
+        }else if (type == "ring-alpha"){
+            ok = check<ring::ring_alpha>(index, query, bindings);
+        }else if (type == "r-ring"){
+            ok = check<ring::r_ring>(index, query, bindings);
+        }else if (type == "ring-adaptive"){
+            ok = check<ring::ring_adaptive>(index, query, bindings);
+        }else{
+            std::cout << "Type of index: " << type << " is not supported." << std::endl;
+            return 1;
+        }
+    }catch(const std::exception &e){
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    std::cout << (ok ? "The prepared query is equal to the separate queries" : "The prepared query DIFFERS from the separate queries") << std::endl;
+    return ok ? 0 : 1;
+}
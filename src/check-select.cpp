@@ -0,0 +1,99 @@
+/*
+ * check-select.cpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <iostream>
+#include <random>
+#include "ring.hpp"
+
+using namespace std;
+
+// Checks that wm_select_stack and wm_select_next_stack, which the rings use when several threads query
+// them, and wm_rank_pair return the same as select, select_next and rank of the wavelet matrices of the
+// installed sdsl.
+// Random sequences of several lengths and alphabets, including all zeros (a matrix without levels), are
+// built into the wavelet matrix of each BWT.
+
+template<class bwt_type>
+bool check(const std::string &name, const uint64_t n, const uint64_t sigma, std::mt19937_64 &gen){
+    typedef typename bwt_type::bwt_type wm_type;
+    sdsl::int_vector<> seq(n, 0, sdsl::bits::hi(sigma) + 1);
+    std::uniform_int_distribution<uint64_t> dist(0, sigma - 1);
+    for(uint64_t i = 0; i < n; ++i) seq[i] = dist(gen);
+    wm_type wm;
+    sdsl::construct_im(wm, seq);
+
+    std::vector<uint64_t> count(sigma, 0);
+    for(uint64_t i = 0; i < n; ++i) ++count[seq[i]];
+    uint64_t n_checks = 0;
+    for(uint64_t c = 0; c < sigma; ++c){
+        for(uint64_t i = 1; i <= count[c]; ++i){
+            if(ring::wm_select_stack(wm, i, c) != wm.select(i, c)){
+                cout << name << ": select(" << i << ", " << c << ") differs (n=" << n << ", sigma=" << sigma << ")" << endl;
+                return false;
+            }
+            ++n_checks;
+        }
+        for(uint64_t pos = 0; pos <= n; ++pos){
+            if(ring::wm_rank_pair(wm, pos, n, c) != std::make_pair(wm.rank(pos, c), wm.rank(n, c))){
+                cout << name << ": rank_pair(" << pos << ", " << n << ", " << c << ") differs (n=" << n << ", sigma=" << sigma << ")" << endl;
+                return false;
+            }
+            ++n_checks;
+        }
+        if(count[c] == 0) continue;
+        for(uint64_t pos = 0; pos <= n; ++pos){
+            if(ring::wm_select_next_stack(wm, pos, c, count[c]) != wm.select_next(pos, c, count[c])){
+                cout << name << ": select_next(" << pos << ", " << c << ") differs (n=" << n << ", sigma=" << sigma << ")" << endl;
+                return false;
+            }
+            ++n_checks;
+        }
+    }
+    cout << name << ": n=" << n << " sigma=" << sigma << " " << n_checks << " checks, equal" << endl;
+    return true;
+}
+
+template<class bwt_type>
+bool check_all(const std::string &name, std::mt19937_64 &gen){
+    const uint64_t lengths[] = {1, 100, 5000};
+    const uint64_t sigmas[] = {1, 2, 3, 64, 1000};
+    bool ok = true;
+    for(uint64_t n : lengths){
+        for(uint64_t sigma : sigmas){
+            ok = check<bwt_type>(name, n, sigma, gen) && ok;
+        }
+    }
+    return ok;
+}
+
+
+int main(int argc, char* argv[])
+{
+    uint64_t seed = argc > 1 ? std::stoull(argv[1]) : 1;
+    std::mt19937_64 gen(seed);
+
+    bool ok = check_all<ring::bwt_no_select>("bwt", gen);
+    ok = check_all<ring::bwt_plain>("bwt_plain", gen) && ok;
+    ok = check_all<ring::bwt_sampled>("bwt_sampled", gen) && ok;
+    ok = check_all<ring::bwt_rrr>("bwt_rrr", gen) && ok;
+    ok = check_all<ring::bwt_cl>("bwt_cl", gen) && ok;
+    std::cout << (ok ? "wm_select is equal to the select of the sdsl" : "wm_select DIFFERS from the select of the sdsl") << std::endl;
+    return ok ? 0 : 1;
+}
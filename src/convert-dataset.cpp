@@ -0,0 +1,53 @@
+/*
+ * convert-dataset.cpp
+ * Copyright (C) 2020 Author removed for double-blind evaluation
+ *
+ *
+ * This is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include <iostream>
+#include <triple_io.hpp>
+
+using namespace std;
+
+using namespace std::chrono;
+using timer = std::chrono::high_resolution_clock;
+
+int main(int argc, char **argv)
+{
+
+    if(argc != 3){
+        std::cout << "Usage: " << argv[0] << " <text-dataset> <binary-dataset>" << std::endl;
+        return 0;
+    }
+
+    std::string dataset = argv[1];
+    std::string output  = argv[2];
+
+    auto start = timer::now();
+    uint64_t n;
+    try{
+        n = ring::convert_to_binary(dataset, output);
+    }catch(const std::runtime_error &e){
+        cerr << "Error: " << e.what() << endl;
+        return 1;
+    }
+    auto stop = timer::now();
+    cout << "Converted " << n << " triples" << endl;
+    cout << duration_cast<seconds>(stop-start).count() << " seconds." << endl;
+
+    return 0;
+}
@@ -17,12 +17,16 @@
  * with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+
+#include <fstream>
 #include <iostream>
 #include <utility>
 #include "ring.hpp"
 #include <chrono>
 #include <triple_pattern.hpp>
 #include <ltj_algorithm.hpp>
+#include <query_executor.hpp>
+#include <query_parser.hpp>
 #include "utils.hpp"
 
 using namespace std;
@@ -32,203 +36,141 @@ using namespace std;
 
 using namespace std::chrono;
 
-bool get_file_content(string filename, vector<string> & vector_of_strings)
-{
-    // Open the File
-    ifstream in(filename.c_str());
-    // Check if object is valid
-    if(!in)
-    {
-        cerr << "Cannot open the File : " << filename << endl;
-        return false;
-    }
-    string str;
-    // Read the next line from File until it reaches the end.
-    while (getline(in, str))
-    {
-        // Line contains string of length > 0 then save it in vector
-        if(str.size() > 0)
-            vector_of_strings.push_back(str);
-    }
-    //Close The File
-    in.close();
-    return true;
-}
-
-std::string ltrim(const std::string &s)
-{
-    size_t start = s.find_first_not_of(' ');
-    return (start == std::string::npos) ? "" : s.substr(start);
-}
-
-std::string rtrim(const std::string &s)
-{
-    size_t end = s.find_last_not_of(' ');
-    return (end == std::string::npos) ? "" : s.substr(0, end + 1);
-}
-
-std::string trim(const std::string &s) {
-    return rtrim(ltrim(s));
-}
-
-std::vector<std::string> tokenizer(const std::string &input, const char &delimiter){
-    std::stringstream stream(input);
-    std::string token;
-    std::vector<std::string> res;
-    while(getline(stream, token, delimiter)){
-        res.emplace_back(trim(token));
-    }
-    return res;
-}
-
-bool is_variable(string & s)
-{
-    return (s.at(0) == '?');
-}
-
-uint8_t get_variable(string &s, std::unordered_map<std::string, uint8_t> &hash_table_vars){
-    auto var = s.substr(1);
-    auto it = hash_table_vars.find(var);
-    if(it == hash_table_vars.end()){
-        uint8_t id = hash_table_vars.size();
-        hash_table_vars.insert({var, id });
-        return id;
-    }else{
-        return it->second;
-    }
-}
-
-uint64_t get_constant(string &s){
-    return std::stoull(s);
-}
-
-ring::triple_pattern get_triple(string & s, std::unordered_map<std::string, uint8_t> &hash_table_vars) {
-    vector<string> terms = tokenizer(s, ' ');
-
-    ring::triple_pattern triple;
-    if(is_variable(terms[0])){
-        triple.var_s(get_variable(terms[0], hash_table_vars));
-    }else{
-        triple.const_s(get_constant(terms[0]));
-    }
-    if(is_variable(terms[1])){
-        triple.var_p(get_variable(terms[1], hash_table_vars));
-    }else{
-        triple.const_p(get_constant(terms[1]));
-    }
-    if(is_variable(terms[2])){
-        triple.var_o(get_variable(terms[2], hash_table_vars));
-    }else{
-        triple.const_o(get_constant(terms[2]));
-    }
-    return triple;
-}
-
 std::string get_type(const std::string &file){
+    std::string type = ring::index_format::read_variant(file);
+    if(!type.empty()) return type;
+    // Indexes without header: the type is given by the extension
     auto p = file.find_last_of('.');
     return file.substr(p+1);
 }
 
 
 template<class ring_type>
-void query(const std::string &file, const std::string &queries){
+void run_queries(const ring_type &graph, const std::string &queries, const uint64_t n_threads,
+                 const uint64_t join_threads, const std::string &output, const bool count_only,
+                 const bool adaptive, const bool use_plan_cache, const bool leaps){
     vector<string> dummy_queries;
-    bool result = get_file_content(queries, dummy_queries);
-
-    ring_type graph;
-
-    cout << " Loading the index..."; fflush(stdout);
-    sdsl::load_from_file(graph, file);
-
-    cout << endl << " Index loaded " << sdsl::size_in_bytes(graph) << " bytes" << endl;
-
-    std::ifstream ifs;
-    uint64_t nQ = 0;
-
-    high_resolution_clock::time_point start, stop;
-    double total_time = 0.0;
-    duration<double> time_span;
+    bool result = ring::query_parser::get_file_content(queries, dummy_queries);
 
     if(result)
     {
-
-        int count = 1;
-        for (string& query_string : dummy_queries) {
-
-            //vector<Term*> terms_created;
-            //vector<Triple*> query;
-            std::unordered_map<std::string, uint8_t> hash_table_vars;
-            std::vector<ring::triple_pattern> query;
-            vector<string> tokens_query = tokenizer(query_string, '.');
-            for (string& token : tokens_query) {
-                auto triple_pattern = get_triple(token, hash_table_vars);
-                query.push_back(triple_pattern);
+        // The queries are independent: each thread runs the next one over the same ring
+        ring::query_executor<ring_type> executor(&graph, n_threads, 1000, 600, join_threads);
+        executor.set_count_only(count_only);
+        executor.set_adaptive(adaptive);
+        typename ring::query_executor<ring_type>::plan_cache_type cache;
+        if(use_plan_cache) executor.set_plan_cache(&cache);
+        // The results are streamed to the output file instead of being stored
+        std::ofstream out;
+        if(!output.empty()){
+            out.open(output);
+            if(!out){
+                cerr << "Cannot create the file : " << output << endl;
+                return;
             }
-
-
-            // vector<string> gao = get_gao(query);
-            // vector<string> gao = get_gao_min_opt(query, graph);
-            // cout << gao [0] << " - " << gao [1] << " - " << gao[2] << endl;
-
-            start = high_resolution_clock::now();
-
-            ring::ltj_algorithm<ring_type> ltj(&query, &graph);
-
-            typedef std::vector<typename ring::ltj_algorithm<>::tuple_type> results_type;
-            results_type res;
-
-            std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
-
-            ltj.join(res, 1000, 600);
-            //std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
-
-            stop = high_resolution_clock::now();
-            time_span = duration_cast<microseconds>(stop - start);
-            total_time = time_span.count();
-
-            /*std::unordered_map<uint8_t, std::string> ht;
-            for(const auto &p : hash_table_vars){
-                ht.insert({p.second, p.first});
-            }
-
-            cout << "Query Details:" << endl;
-            ltj.print_query(ht);
-            ltj.print_gao(ht);
-            cout << "##########" << endl;*/
-
-            cout << nQ <<  ";" << res.size() << ";" << (unsigned long long)(total_time*1000000000ULL) << endl;
-            nQ++;
-
-            // cout << std::chrono::duration_cast<std::chrono::nanoseconds> (end - begin).count() << std::endl;
-
-            //cout << "RESULTS QUERY " << count << ": " << number_of_results << endl;
-            count += 1;
+            executor.set_output(&out);
+        }
+        std::vector<ring::query_stats_type> stats;
+        uint64_t total_time = executor.run(dummy_queries, stats);
+
+        uint64_t sum_time = 0, sum_leaps = 0;
+        for(uint64_t nQ = 0; nQ < stats.size(); ++nQ){
+            cout << nQ <<  ";" << stats[nQ].n_results << ";" << stats[nQ].time_ns;
+            if(leaps) cout << ";" << stats[nQ].n_leaps;
+            cout << endl;
+            sum_time += stats[nQ].time_ns;
+            sum_leaps += stats[nQ].n_leaps;
         }
 
+        double seconds = total_time / 1000000000.0;
+        cout << "Queries: " << stats.size() << " Threads: " << n_threads
+             << " Elapsed: " << total_time << " ns"
+             << " Avg latency: " << (stats.empty() ? 0 : sum_time / stats.size()) << " ns"
+             << " Throughput: " << (seconds > 0 ? stats.size() / seconds : 0) << " queries/s" << endl;
+        if(use_plan_cache){
+            cout << "Plan cache: " << cache.size() << " plans " << cache.hits() << " hits" << endl;
+        }
+        if(leaps){
+            cout << "Leaps: " << sum_leaps << endl;
+        }
     }
 }
 
+template<class ring_type>
+void query(const std::string &file, const std::string &queries, const uint64_t n_threads,
+           const uint64_t join_threads, const std::string &output, const bool count_only,
+           const bool adaptive, const bool use_plan_cache, const bool leaps){
+    ring_type graph;
+    cout << " Loading the index..."; fflush(stdout);
+    sdsl::load_from_file(graph, file);
+    graph.set_concurrent_select(n_threads > 1 || join_threads > 1);
+    cout << endl << " Index loaded " << sdsl::size_in_bytes(graph) << " bytes" << endl;
+    run_queries(graph, queries, n_threads, join_threads, output, count_only, adaptive, use_plan_cache, leaps);
+}
+
 
 int main(int argc, char* argv[])
 {
 
     typedef ring::ring<> ring_type;
     //typedef ring::c_ring ring_type;
-    if(argc != 3){
-        std::cout << "Usage: " << argv[0] << " <index> <queries>" << std::endl;
+    uint64_t n_threads = 1;
+    uint64_t join_threads = 1;
+    std::string output;
+    bool count_only = false;
+    bool adaptive = false;
+    bool use_plan_cache = false;
+    bool leaps = false;
+    bool ok = (argc >= 3);
+    for(int i = 3; ok && i < argc; ++i){
+        std::string arg = argv[i];
+        if(arg == "--threads" && i+1 < argc){
+            n_threads = std::max(std::stoull(argv[++i]), 1ULL);
+        }else if(arg == "--join-threads" && i+1 < argc){
+            join_threads = std::max(std::stoull(argv[++i]), 1ULL);
+        }else if(arg == "--count"){
+            count_only = true;
+        }else if(arg == "--adaptive"){
+            adaptive = true;
+        }else if(arg == "--plan-cache"){
+            use_plan_cache = true;
+        }else if(arg == "--leaps"){
+            leaps = true;
+        }else if(arg == "--output" && i+1 < argc){
+            output = argv[++i];
+        }else{
+            ok = false;
+        }
+    }
+    if(!ok){
+        std::cout << "Usage: " << argv[0] << " <index> <queries> [--threads <n>] [--join-threads <n>] [--output <file>] [--count] [--adaptive] [--plan-cache] [--leaps]" << std::endl;
         return 0;
     }
 
     std::string index = argv[1];
     std::string queries = argv[2];
     std::string type = get_type(index);
+    // Only these variants select with the kernels chosen for the CPU (see cpu_kernels.hpp)
+    if(type == "ring-cl" || type == "ring-sampled"){
+        std::cout << "Rank/select kernels: " << ring::kernels::active().name << std::endl;
+    }
 
     if(type == "ring"){
-        query<ring::ring<>>(index, queries);
+        query<ring::ring<>>(index, queries, n_threads, join_threads, output, count_only, adaptive, use_plan_cache, leaps);
     }else if (type == "c-ring"){
-        query<ring::c_ring>(index, queries);
+        query<ring::c_ring>(index, queries, n_threads, join_threads, output, count_only, adaptive, use_plan_cache, leaps);
     }else if (type == "ring-sel"){
-        query<ring::ring_sel>(index, queries);
+        query<ring::ring_sel>(index, queries, n_threads, join_threads, output, count_only, adaptive, use_plan_cache, leaps);
+    }else if (type == "ring-cl"){
+        query<ring::ring_cl>(index, queries, n_threads, join_threads, output, count_only, adaptive, use_plan_cache, leaps);
+    }else if (type == "ring-sampled"){
+        query<ring::ring_sampled>(index, queries, n_threads, join_threads, output, count_only, adaptive, use_plan_cache, leaps);
+    }else if (type == "ring-alpha"){
+        query<ring::ring_alpha>(index, queries, n_threads, join_threads, output, count_only, adaptive, use_plan_cache, leaps);
+    }else if (type == "r-ring"){
+        query<ring::r_ring>(index, queries, n_threads, join_threads, output, count_only, adaptive, use_plan_cache, leaps);
+    }else if (type == "ring-adaptive"){
+        query<ring::ring_adaptive>(index, queries, n_threads, join_threads, output, count_only, adaptive, use_plan_cache, leaps);
     }else{
         std::cout << "Type of index: " << type << " is not supported." << std::endl;
     }